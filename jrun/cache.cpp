@@ -0,0 +1,168 @@
+/// Denom.org
+///
+/// MIT No Attribution.
+///
+/// Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software
+/// without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+/// permit persons to whom the Software is furnished to do so.
+///
+/// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+/// PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+/// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+///
+/// Author:  Sergey Novochenko,  Digrol@gmail.com
+///
+/// Content-addressed cache of compiled classes.
+
+#include <string>
+#include <vector>
+#include "utils.h"
+#include "exception.h"
+#include "sha256.h"
+#include "metrics.h"
+#include "trace.h"
+#include "cache.h"
+
+#ifdef _WIN32
+#include <process.h>
+#define getpid _getpid
+#else
+#include <unistd.h>
+#endif
+
+namespace fs = std::filesystem;
+using std::string;
+using std::wstring;
+using std::vector;
+using namespace Denom;
+
+/// Changing of cache layout or key structure requires new version.
+static const char CACHE_VERSION[] = "jrun-cache-2";
+
+// ---------------------------------------------------------------------------------------------------------------------
+static fs::path defaultCacheRoot()
+{
+	#ifdef _WIN32
+		wstring base = getEnv( L"LOCALAPPDATA" );
+		MUST_M( !base.empty(), L"Can't find cache directory: LOCALAPPDATA is not set" );
+		return toPath( base ) / "jrun";
+	#else
+		wstring base = getEnv( L"XDG_CACHE_HOME" );
+		if( !base.empty() )
+			return toPath( base ) / "jrun";
+
+		wstring home = getEnv( L"HOME" );
+		MUST_M( !home.empty(), L"Can't find cache directory: neither XDG_CACHE_HOME nor HOME are set" );
+		return toPath( home ) / ".cache" / "jrun";
+	#endif
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+CompileCache::CompileCache() : root( defaultCacheRoot() )
+{
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+CompileCache::CompileCache( const fs::path& root ) : root( root )
+{
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+static void hashString( IHash& alg, const string& str )
+{
+	// Strings are hashed with terminating zero to separate them
+	alg.process( (const uint8_t*)str.c_str(), str.size() + 1 );
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+Binary CompileCache::makeKey( const Binary& source, const wstring& mainClass, const string& jdkIdentity,
+	const vector<wstring>& flags )
+{
+	TraceSpan span( "CompileCache::makeKey" );
+	Sha256 alg;
+	hashString( alg, CACHE_VERSION );
+
+	uint8_t sourceSize[ 8 ];
+	uint64_t sz = source.size();
+	for( int i = 7; i >= 0; --i, sz >>= 8 )
+		sourceSize[ i ] = (uint8_t)sz;
+	alg.process( sourceSize, sizeof(sourceSize) );
+	alg.process( source );
+
+	hashString( alg, w2s( mainClass ) );
+	hashString( alg, jdkIdentity );
+	for( const wstring& flag : flags )
+		hashString( alg, w2s( flag ) );
+
+	return alg.getHash();
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+fs::path CompileCache::entryDir( const Binary& key ) const
+{
+	return root / "classes" / key.hexStr();
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+bool CompileCache::find( const Binary& key, fs::path& classesDir ) const
+{
+	static Counter& hits = Metrics::counter( "cache.hits" );
+	static Counter& misses = Metrics::counter( "cache.misses" );
+	TraceSpan span( "CompileCache::find" );
+
+	std::error_code ec;
+	fs::path dir = entryDir( key );
+	if( !fs::is_directory( dir, ec ) )
+	{
+		misses.add();
+		return false;
+	}
+
+	hits.add();
+	classesDir = dir;
+	return true;
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+fs::path CompileCache::createStagingDir( const Binary& key ) const
+{
+	std::error_code ec;
+	fs::path tmpRoot = root / "tmp";
+	fs::create_directories( tmpRoot, ec );
+	MUST_M( !ec, L"Can't create cache directory: " + fromPath( tmpRoot ) );
+
+	// Unique name: several launches of the same programme can compile it simultaneously, and abandoned directory
+	// can still be written by hung compile server
+	static int counter = 0;
+	string name = key.hexStr() + "." + std::to_string( getpid() ) + "." + std::to_string( ++counter );
+	fs::path dir = tmpRoot / name;
+	fs::remove_all( dir, ec );
+	MUST_M( fs::create_directory( dir, ec ), L"Can't create directory: " + fromPath( dir ) );
+	return dir;
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+fs::path CompileCache::commit( const Binary& key, const fs::path& stagingDir ) const
+{
+	TraceSpan span( "CompileCache::commit" );
+	std::error_code ec;
+	fs::path dir = entryDir( key );
+	fs::create_directories( dir.parent_path(), ec );
+	MUST_M( !ec, L"Can't create cache directory: " + fromPath( dir.parent_path() ) );
+
+	fs::rename( stagingDir, dir, ec );
+	if( ec )
+	{
+		// Another launch has already published the same entry
+		MUST_M( fs::is_directory( dir, ec ), L"Can't save compiled classes to " + fromPath( dir ) );
+		discard( stagingDir );
+	}
+	return dir;
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+void CompileCache::discard( const fs::path& stagingDir ) const
+{
+	std::error_code ec;
+	fs::remove_all( stagingDir, ec );
+}
@@ -0,0 +1,69 @@
+/// Denom.org
+///
+/// MIT No Attribution.
+///
+/// Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software
+/// without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+/// permit persons to whom the Software is furnished to do so.
+///
+/// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+/// PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+/// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+///
+/// Author:  Sergey Novochenko,  Digrol@gmail.com
+///
+/// Content-addressed cache of compiled classes.
+
+#ifndef CACHE_H_93C27A5D0E8B4F16
+#define CACHE_H_93C27A5D0E8B4F16
+
+#include <string>
+#include <vector>
+#include <filesystem>
+#include "binary.h"
+
+// ---------------------------------------------------------------------------------------------------------------------
+/// Cache of compiled programmes.
+/// Each entry is a directory with class files, produced by 'javac' for one source file.
+/// Entry name is a hash of everything that affects compilation result:
+///     <root>/classes/<sha256-hex>/
+/// Entries are never modified: new entry is compiled into '<root>/tmp' and then renamed,
+/// so concurrent launches never see partially written classes.
+class CompileCache
+{
+public:
+	/// Cache in $XDG_CACHE_HOME/jrun, ~/.cache/jrun or %LOCALAPPDATA%\jrun.
+	CompileCache();
+
+	explicit CompileCache( const std::filesystem::path& root );
+
+	/// Calculates key of cache entry.
+	/// @param source - bytes of source file.
+	/// @param mainClass - main class, its name comes from file name: the same source in other file gives other class.
+	/// @param jdkIdentity - see Jdk::identity.
+	/// @param flags - options for 'javac'.
+	static Denom::Binary makeKey( const Denom::Binary& source, const std::wstring& mainClass,
+		const std::string& jdkIdentity, const std::vector<std::wstring>& flags );
+
+	/// @return true if classes for 'key' are cached, 'classesDir' - directory with them.
+	bool find( const Denom::Binary& key, std::filesystem::path& classesDir ) const;
+
+	/// Creates new empty directory for 'javac' output.
+	std::filesystem::path createStagingDir( const Denom::Binary& key ) const;
+
+	/// Publishes compiled classes from 'stagingDir' under 'key'.
+	/// @return directory of cache entry.
+	std::filesystem::path commit( const Denom::Binary& key, const std::filesystem::path& stagingDir ) const;
+
+	/// Removes staging directory after failed compilation.
+	void discard( const std::filesystem::path& stagingDir ) const;
+
+	const std::filesystem::path& getRoot() const { return root; }
+
+private:
+	std::filesystem::path root;
+
+	std::filesystem::path entryDir( const Denom::Binary& key ) const;
+};
+
+#endif // Header guard
@@ -0,0 +1,240 @@
+/// Denom.org
+///
+/// MIT No Attribution.
+///
+/// Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software
+/// without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+/// permit persons to whom the Software is furnished to do so.
+///
+/// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+/// PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+/// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+///
+/// Author:  Sergey Novochenko,  Digrol@gmail.com
+///
+/// Application Class Data Sharing archive of cached programme.
+
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <chrono>
+#include "utils.h"
+#include "exception.h"
+#include "files.h"
+#include "metrics.h"
+#include "trace.h"
+#include "classarchive.h"
+
+#ifdef _WIN32
+#include <process.h>
+#define getpid _getpid
+#else
+#include <unistd.h>
+#endif
+
+namespace fs = std::filesystem;
+using std::string;
+using std::wstring;
+using std::vector;
+using namespace Denom;
+
+namespace {
+
+// ---------------------------------------------------------------------------------------------------------------------
+uint32_t crc32( const uint8_t* data, size_t size )
+{
+	static const vector<uint32_t> table = []()
+	{
+		vector<uint32_t> t( 256 );
+		for( uint32_t i = 0; i < 256; ++i )
+		{
+			uint32_t c = i;
+			for( int k = 0; k < 8; ++k )
+				c = (c & 1) ? (0xEDB88320 ^ (c >> 1)) : (c >> 1);
+			t[ i ] = c;
+		}
+		return t;
+	}();
+
+	uint32_t crc = 0xFFFFFFFF;
+	for( size_t i = 0; i < size; ++i )
+		crc = table[ (crc ^ data[ i ]) & 0xFF ] ^ (crc >> 8);
+	return crc ^ 0xFFFFFFFF;
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+void putU16( Binary& buf, uint32_t v )
+{
+	buf += (uint8_t)v;
+	buf += (uint8_t)(v >> 8);
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+void putU32( Binary& buf, uint32_t v )
+{
+	putU16( buf, v & 0xFFFF );
+	putU16( buf, v >> 16 );
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+/// Jar with all files of 'dir': ZIP without compression, entries sorted by name and with fixed time,
+/// so jar of the same classes is the same.
+Binary makeJar( const fs::path& dir )
+{
+	TraceSpan span( "ClassArchive::makeJar" );
+	vector<fs::path> files;
+	for( const fs::directory_entry& entry : fs::recursive_directory_iterator( dir ) )
+	{
+		if( entry.is_regular_file() )
+			files.push_back( entry.path() );
+	}
+	std::sort( files.begin(), files.end() );
+	MUST_M( files.size() < 0xFFFF, L"Too many files for jar in " + fromPath( dir ) );
+
+	const uint32_t VERSION = 10;     // 1.0: stored entries
+	const uint32_t UTF8_NAMES = 0x0800;
+	const uint32_t DOS_DATE = 0x21;  // 1980-01-01
+
+	Binary jar;
+	Binary central;
+	for( const fs::path& file : files )
+	{
+		Binary body;
+		body.loadFromFile( file.native() );
+		string name = file.lexically_relative( dir ).generic_u8string();
+		uint32_t crc = crc32( body.data(), body.size() );
+		uint32_t offset = (uint32_t)jar.size();
+
+		putU32( jar, 0x04034B50 );
+		putU16( jar, VERSION );
+		putU16( jar, UTF8_NAMES );
+		putU16( jar, 0 ); // method: stored
+		putU16( jar, 0 ); // time
+		putU16( jar, DOS_DATE );
+		putU32( jar, crc );
+		putU32( jar, (uint32_t)body.size() );
+		putU32( jar, (uint32_t)body.size() );
+		putU16( jar, (uint32_t)name.size() );
+		putU16( jar, 0 ); // extra
+		jar.insert( jar.end(), name.begin(), name.end() );
+		jar += body;
+
+		putU32( central, 0x02014B50 );
+		putU16( central, VERSION ); // made by
+		putU16( central, VERSION );
+		putU16( central, UTF8_NAMES );
+		putU16( central, 0 );
+		putU16( central, 0 );
+		putU16( central, DOS_DATE );
+		putU32( central, crc );
+		putU32( central, (uint32_t)body.size() );
+		putU32( central, (uint32_t)body.size() );
+		putU16( central, (uint32_t)name.size() );
+		putU16( central, 0 ); // extra
+		putU16( central, 0 ); // comment
+		putU16( central, 0 ); // disk
+		putU16( central, 0 ); // internal attributes
+		putU32( central, 0 ); // external attributes
+		putU32( central, offset );
+		central.insert( central.end(), name.begin(), name.end() );
+
+		MUST_M( jar.size() < 0xFFFFFFFF, L"Classes are too large for jar: " + fromPath( dir ) );
+	}
+
+	uint32_t centralOffset = (uint32_t)jar.size();
+	jar += central;
+	putU32( jar, 0x06054B50 );
+	putU16( jar, 0 ); // disk
+	putU16( jar, 0 ); // disk with central directory
+	putU16( jar, (uint32_t)files.size() );
+	putU16( jar, (uint32_t)files.size() );
+	putU32( jar, (uint32_t)central.size() );
+	putU32( jar, centralOffset );
+	putU16( jar, 0 ); // comment
+	return jar;
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+/// Remove dumps of launches, which have been killed before 'complete'. Dump takes seconds, so file of another launch,
+/// which is older than an hour, is left forever.
+void removeStaleDumps( const fs::path& dir )
+{
+	std::error_code ec;
+	fs::file_time_type staleTime = fs::file_time_type::clock::now() - std::chrono::hours( 1 );
+	for( fs::directory_iterator it( dir, ec ), end; !ec && (it != end); it.increment( ec ) )
+	{
+		const fs::path& file = it->path();
+		std::error_code fileEc;
+		if( (file.extension() == ".tmp") && (fs::last_write_time( file, fileEc ) < staleTime) && !fileEc )
+			fs::remove( file, fileEc );
+	}
+}
+
+} // namespace
+
+// ---------------------------------------------------------------------------------------------------------------------
+ClassArchive::ClassArchive( const fs::path& cacheRoot, const Binary& key )
+{
+	string name = key.hexStr();
+	jarFile = cacheRoot / "cds" / (name + ".jar");
+	archiveFile = cacheRoot / "cds" / (name + ".jsa");
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+bool ClassArchive::addJavaOptions( const fs::path& classesDir, vector<wstring>& javaArgs )
+{
+	static Counter& hits = Metrics::counter( "cds.hits" );
+	static Counter& dumps = Metrics::counter( "cds.dumps" );
+
+	std::error_code ec;
+	if( !fs::is_regular_file( jarFile, ec ) )
+	{
+		try
+		{
+			fs::create_directories( jarFile.parent_path(), ec );
+			Binary jar = makeJar( classesDir );
+			writeFileAtomic( jarFile.native(), jar.data(), jar.size() );
+		}
+		catch( Denom::Exception& )
+		{
+			return false;
+		}
+		catch( const std::exception& ) // fs::filesystem_error
+		{
+			return false;
+		}
+	}
+
+	// Warnings of CDS (skipped classes, mismatch of archive) are printed to stdout and would mix with output of programme
+	javaArgs.push_back( L"-Xlog:cds*=off" );
+	if( fs::is_regular_file( archiveFile, ec ) )
+	{
+		hits.add();
+		javaArgs.push_back( L"-XX:SharedArchiveFile=" + fromPath( archiveFile ) );
+	}
+	else
+	{
+		// Unique name: several launches can dump archive simultaneously
+		dumps.add();
+		removeStaleDumps( archiveFile.parent_path() );
+		dumpFile = archiveFile;
+		dumpFile += "." + std::to_string( getpid() ) + ".tmp";
+		javaArgs.push_back( L"-XX:ArchiveClassesAtExit=" + fromPath( dumpFile ) );
+	}
+	javaArgs.push_back( L"-cp" );
+	javaArgs.push_back( fromPath( jarFile ) );
+	return true;
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+void ClassArchive::complete( int exitCode )
+{
+	if( dumpFile.empty() )
+		return;
+
+	std::error_code ec;
+	if( (exitCode == 0) && fs::is_regular_file( dumpFile, ec ) )
+		fs::rename( dumpFile, archiveFile, ec );
+	fs::remove( dumpFile, ec );
+	dumpFile.clear();
+}
@@ -0,0 +1,60 @@
+/// Denom.org
+///
+/// MIT No Attribution.
+///
+/// Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software
+/// without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+/// permit persons to whom the Software is furnished to do so.
+///
+/// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+/// PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+/// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+///
+/// Author:  Sergey Novochenko,  Digrol@gmail.com
+///
+/// Application Class Data Sharing archive of cached programme.
+
+#ifndef CLASSARCHIVE_H_C85A1F3E6D20B947
+#define CLASSARCHIVE_H_C85A1F3E6D20B947
+
+#include <string>
+#include <vector>
+#include <filesystem>
+#include "binary.h"
+#include "jdk.h"
+
+// ---------------------------------------------------------------------------------------------------------------------
+/// Dynamic AppCDS archive: JVM maps classes, already parsed and verified on previous run, instead of loading them
+/// from class files. First successful run of cached programme dumps archive by -XX:ArchiveClassesAtExit,
+/// next runs use it by -XX:SharedArchiveFile.
+/// Files are named by key of compile cache entry, which includes hash of source and JDK identity, so update of JDK
+/// leads to new archive:
+///     <cacheRoot>/cds/<key>.jar - classes of entry: JVM archives classes only from jar files, not from directories;
+///     <cacheRoot>/cds/<key>.jsa - archive.
+/// Archive is only an optimization: if something fails, programme runs from classes directory as usual.
+class ClassArchive
+{
+public:
+	ClassArchive( const std::filesystem::path& cacheRoot, const Denom::Binary& key );
+
+	/// -XX:ArchiveClassesAtExit appeared in JDK 13.
+	static bool isSupported( const Jdk& jdk ) { return jdk.version >= 13; }
+
+	/// Adds options of 'java': class path and archive to use or to create.
+	/// Creates jar of 'classesDir' on the first call for this key.
+	/// @return false if jar can't be created, 'javaArgs' are not changed then.
+	bool addJavaOptions( const std::filesystem::path& classesDir, std::vector<std::wstring>& javaArgs );
+
+	/// true if JVM, started with options from 'addJavaOptions', dumps archive, and 'complete' must be called.
+	bool isDumping() const { return !dumpFile.empty(); }
+
+	/// Publishes archive, dumped at exit of JVM, if programme has exited successfully; otherwise removes it.
+	void complete( int exitCode );
+
+private:
+	std::filesystem::path jarFile;
+	std::filesystem::path archiveFile;
+	std::filesystem::path dumpFile; // not empty while archive is being dumped
+};
+
+#endif // Header guard
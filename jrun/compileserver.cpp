@@ -0,0 +1,325 @@
+/// Denom.org
+///
+/// MIT No Attribution.
+///
+/// Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software
+/// without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+/// permit persons to whom the Software is furnished to do so.
+///
+/// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+/// PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+/// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+///
+/// Author:  Sergey Novochenko,  Digrol@gmail.com
+///
+/// Compile server: warm JVM with javac, which compiles sources by requests of jrun.
+
+#include <string>
+#include <vector>
+#include <atomic>
+#include <cstdio>
+#include <cerrno>
+#include "utils.h"
+#include "exception.h"
+#include "binary.h"
+#include "binaryspan.h"
+#include "files.h"
+#include "log.h"
+#include "logger.h"
+#include "metrics.h"
+#include "sha256.h"
+#include "childprocess.h"
+#include "localsocket.h"
+#include "compileserver.h"
+
+#ifndef _WIN32
+#include <signal.h>
+#include <unistd.h>
+#endif
+
+namespace fs = std::filesystem;
+using std::string;
+using std::wstring;
+using std::vector;
+using namespace Denom;
+
+namespace {
+
+const uint32_t MAGIC = 0x4A524331; // "JRC1"
+
+const char SERVER_CLASS[] = "JRunCompileServer";
+
+/// Server, which does not answer during this time, is considered hung: jrun runs javac itself.
+const int TIMEOUT_MS = 60000;
+
+// ---------------------------------------------------------------------------------------------------------------------
+/// Java part of server. Relative paths in requests are resolved against working directory of client.
+const char SERVER_SOURCE[] = R"JAVA(// Generated by jrun, see compileserver.cpp
+import java.io.*;
+import java.net.StandardProtocolFamily;
+import java.net.UnixDomainSocketAddress;
+import java.nio.channels.*;
+import java.nio.charset.StandardCharsets;
+import java.nio.file.*;
+import java.nio.file.attribute.UserPrincipal;
+import java.util.Set;
+import javax.tools.JavaCompiler;
+import javax.tools.ToolProvider;
+import jdk.net.ExtendedSocketOptions;
+
+public class JRunCompileServer
+{
+	static final int MAGIC = 0x4A524331;
+
+	static final Set<String> PATH_OPTIONS = Set.of( "-cp", "-classpath", "--class-path", "-sourcepath",
+		"--source-path", "-d", "-s", "-h", "-p", "--module-path", "-processorpath", "--processor-path",
+		"--processor-module-path", "--upgrade-module-path", "--module-source-path", "--system" );
+
+	public static void main( String[] args ) throws Exception
+	{
+		JavaCompiler compiler = ToolProvider.getSystemJavaCompiler();
+		Path socketPath = Path.of( args[ 0 ] );
+		Files.deleteIfExists( socketPath );
+		ServerSocketChannel server = ServerSocketChannel.open( StandardProtocolFamily.UNIX );
+		server.bind( UnixDomainSocketAddress.of( socketPath ) );
+		UserPrincipal owner = Files.getOwner( socketPath );
+		while( true )
+		{
+			SocketChannel client = server.accept();
+			if( !isOwner( client, owner ) )
+			{
+				client.close();
+				continue;
+			}
+			Thread thread = new Thread( () -> serve( compiler, client ) );
+			thread.setDaemon( true );
+			thread.start();
+		}
+	}
+
+	/// Only processes of the same user may compile: javac reads and writes files as this user.
+	static boolean isOwner( SocketChannel client, UserPrincipal owner )
+	{
+		try
+		{
+			return client.getOption( ExtendedSocketOptions.SO_PEERCRED ).user().equals( owner );
+		}
+		catch( IOException | UnsupportedOperationException ex )
+		{
+			return false;
+		}
+	}
+
+	static void serve( JavaCompiler compiler, SocketChannel channel )
+	{
+		try( channel )
+		{
+			DataInputStream in = new DataInputStream( new BufferedInputStream( Channels.newInputStream( channel ) ) );
+			if( in.readInt() != MAGIC )
+				return;
+			String[] strings = new String[ in.readInt() ];
+			for( int i = 0; i < strings.length; ++i )
+			{
+				byte[] bytes = new byte[ in.readInt() ];
+				in.readFully( bytes );
+				strings[ i ] = new String( bytes, StandardCharsets.UTF_8 );
+			}
+
+			Path cwd = Path.of( strings[ 0 ] );
+			String[] javacArgs = new String[ strings.length - 1 ];
+			for( int i = 0; i < javacArgs.length; ++i )
+			{
+				String arg = strings[ i + 1 ];
+				if( (i > 0) && PATH_OPTIONS.contains( javacArgs[ i - 1 ] ) )
+					arg = resolvePathList( cwd, arg );
+				else if( arg.startsWith( "@" ) )
+					arg = "@" + cwd.resolve( arg.substring( 1 ) );
+				else if( !arg.startsWith( "-" ) && arg.endsWith( ".java" ) )
+					arg = cwd.resolve( arg ).toString();
+				javacArgs[ i ] = arg;
+			}
+
+			ByteArrayOutputStream diagnostics = new ByteArrayOutputStream();
+			int code;
+			try
+			{
+				code = compiler.run( null, diagnostics, diagnostics, javacArgs );
+			}
+			catch( Throwable ex )
+			{
+				ex.printStackTrace( new PrintStream( diagnostics, true ) );
+				code = 4;
+			}
+
+			byte[] text = diagnostics.toByteArray();
+			DataOutputStream out = new DataOutputStream( new BufferedOutputStream( Channels.newOutputStream( channel ) ) );
+			out.writeInt( code );
+			out.writeInt( text.length );
+			out.write( text );
+			out.flush();
+		}
+		catch( IOException ex )
+		{
+			// Client has gone
+		}
+	}
+
+	static String resolvePathList( Path cwd, String list )
+	{
+		String[] parts = list.split( File.pathSeparator, -1 );
+		for( int i = 0; i < parts.length; ++i )
+		{
+			if( !parts[ i ].isEmpty() )
+				parts[ i ] = cwd.resolve( parts[ i ] ).toString();
+		}
+		return String.join( File.pathSeparator, parts );
+	}
+}
+)JAVA";
+
+#ifndef _WIN32
+
+// ---------------------------------------------------------------------------------------------------------------------
+std::atomic<bool> stopRequested( false );
+std::atomic<pid_t> serverPid( 0 );
+
+void onStopSignal( int )
+{
+	stopRequested = true;
+	pid_t pid = serverPid;
+	if( pid > 0 )
+		kill( pid, SIGTERM );
+}
+
+#endif // !_WIN32
+
+} // namespace
+
+namespace CompileServer {
+
+// ---------------------------------------------------------------------------------------------------------------------
+fs::path socketPath( const fs::path& cacheRoot, const Jdk& jdk )
+{
+	uint8_t hash[ HASH_SIZE_SHA256 ];
+	calcHashSHA256( (const uint8_t*)jdk.identity.data(), jdk.identity.size(), hash );
+	return cacheRoot / "server" / ("javac-" + BinarySpan( hash, 8 ).hexStr() + ".sock");
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+fs::path writeSource( const fs::path& cacheRoot )
+{
+	fs::path dir = cacheRoot / "server";
+	std::error_code ec;
+	fs::create_directories( dir, ec );
+	MUST_M( !ec, L"Can't create directory: " + fromPath( dir ) );
+
+	fs::path file = dir / (string( SERVER_CLASS ) + ".java");
+	BinarySpan source( (const uint8_t*)SERVER_SOURCE, sizeof( SERVER_SOURCE ) - 1 );
+	Binary existing;
+	if( !existing.tryLoadFromFile( file.native() ) || (BinarySpan( existing ) != source) )
+		writeFileAtomic( file.native(), source.data(), source.size() );
+	return file;
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+int run( const Jdk& jdk, const fs::path& classesDir, const fs::path& socketPath )
+{
+	#ifdef _WIN32
+		THROW_M( L"Compile server is not supported on Windows" );
+	#else
+		Expected<int> running = LocalSocket::connectTo( socketPath );
+		if( running )
+		{
+			close( *running );
+			THROW_M( L"Compile server is already running: " + fromPath( socketPath ) );
+		}
+
+		LocalSocket::createPrivateDirectory( socketPath.parent_path() );
+
+		struct sigaction action = {};
+		action.sa_handler = onStopSignal;
+		sigaction( SIGINT, &action, nullptr );
+		sigaction( SIGTERM, &action, nullptr );
+
+		Process server( { fromPath( jdk.java ), L"-cp", fromPath( classesDir ), s2w( SERVER_CLASS ), fromPath( socketPath ) } );
+
+		int quickExits = 0;
+		while( !stopRequested )
+		{
+			Ticker ticker;
+			server.start();
+			pid_t pid = (pid_t)server.getId();
+			serverPid = pid;
+			// Signal could come before 'serverPid' was set
+			if( stopRequested )
+				kill( pid, SIGTERM );
+			LOGI( "Compile server started, pid {}, socket {}", (int)pid, socketPath.string() );
+
+			int code = server.wait();
+			serverPid = 0;
+			if( stopRequested )
+				break;
+
+			quickExits = (ticker.diffMs() < 5000) ? quickExits + 1 : 0;
+			MUST_M( quickExits < 3, L"Compile server exits right after start (JDK 16+ is required)" );
+			LOGW( "Compile server exited with code {}, restarting", code );
+			Denom::sleep( 1000 );
+		}
+
+		std::error_code ec;
+		fs::remove( socketPath, ec );
+		LOGI( "Compile server stopped" );
+		return 0;
+	#endif
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+Expected<int> compile( const fs::path& socketPath, const vector<wstring>& javacArgs )
+{
+	#ifdef _WIN32
+		return Error{ ErrorCode::NotFound, "Compile server is not supported on Windows", 0 };
+	#else
+		static Counter& served = Metrics::counter( "javac.server" );
+		static Counter& timeouts = Metrics::counter( "javac.serverTimeouts" );
+
+		Expected<int> fd = LocalSocket::connectTo( socketPath, TIMEOUT_MS );
+		if( !fd )
+			return fd.error();
+
+		string request;
+		LocalSocket::putU32( request, MAGIC );
+		LocalSocket::putU32( request, (uint32_t)javacArgs.size() + 1 );
+		std::error_code ec;
+		LocalSocket::putString( request, fs::current_path( ec ).string() );
+		for( const wstring& arg : javacArgs )
+			LocalSocket::putString( request, w2s( arg ) );
+
+		uint32_t code = 0;
+		uint32_t length = 0;
+		string diagnostics;
+		errno = 0;
+		bool ok = LocalSocket::sendAll( *fd, request.data(), request.size() ) &&
+			LocalSocket::recvU32( *fd, code ) && LocalSocket::recvU32( *fd, length );
+		if( ok )
+		{
+			diagnostics.resize( length );
+			ok = LocalSocket::recvAll( *fd, &diagnostics[ 0 ], length );
+		}
+		int err = errno;
+		close( *fd );
+		if( !ok && ((err == EAGAIN) || (err == EWOULDBLOCK)) )
+		{
+			timeouts.add();
+			return Error{ ErrorCode::IoError, "Compile server does not respond", ETIMEDOUT };
+		}
+		if( !ok )
+			return Error::fromErrno( "Compile server closed connection", err );
+
+		fwrite( diagnostics.data(), 1, diagnostics.size(), stderr );
+		fflush( stderr );
+		served.add();
+		return (int)code;
+	#endif
+}
+
+} // namespace CompileServer
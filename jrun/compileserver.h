@@ -0,0 +1,56 @@
+/// Denom.org
+///
+/// MIT No Attribution.
+///
+/// Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software
+/// without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+/// permit persons to whom the Software is furnished to do so.
+///
+/// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+/// PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+/// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+///
+/// Author:  Sergey Novochenko,  Digrol@gmail.com
+///
+/// Compile server: warm JVM with javac, which compiles sources by requests of jrun.
+
+#ifndef COMPILESERVER_H_A73F0C5E19B2D846
+#define COMPILESERVER_H_A73F0C5E19B2D846
+
+#include <string>
+#include <vector>
+#include <filesystem>
+#include "expected.h"
+#include "jdk.h"
+
+// ---------------------------------------------------------------------------------------------------------------------
+/// One long-lived JVM hosts javax.tools.JavaCompiler and listens on Unix domain socket; jrun sends compile requests
+/// to it instead of starting 'javac', which saves JVM startup and JIT warm-up of compiler on each compilation.
+/// Server is started by 'jrun --server'. Requires JDK 16+, not supported on Windows.
+/// Socket directory is accessible only by its owner, and server serves only clients of the same user.
+///
+/// Protocol (numbers - 32-bit big-endian):
+///     request:  magic, count, count * (length, UTF-8 bytes) - working directory, then arguments of javac;
+///     response: exit code of javac, length, UTF-8 diagnostics.
+namespace CompileServer
+{
+	/// Socket of server for 'jdk': <cacheRoot>/server/javac-<hash of JDK identity>.sock
+	std::filesystem::path socketPath( const std::filesystem::path& cacheRoot, const Jdk& jdk );
+
+	/// Writes Java source of server to <cacheRoot>/server/ (only if it differs).
+	/// @return path of source file.
+	std::filesystem::path writeSource( const std::filesystem::path& cacheRoot );
+
+	/// Runs JVM with server from 'classesDir' and restarts it if it exits.
+	/// Returns on SIGINT / SIGTERM; throws if JVM exits right after start several times.
+	int run( const Jdk& jdk, const std::filesystem::path& classesDir, const std::filesystem::path& socketPath );
+
+	/// Compile by server. Diagnostics of javac are printed to stderr.
+	/// @param javacArgs - arguments of javac, without executable.
+	/// @return exit code of javac; error if server is not running - caller should run javac itself.
+	/// Error with sysError ETIMEDOUT: server has not answered within a minute, it can still write into output
+	/// directory of javac.
+	Denom::Expected<int> compile( const std::filesystem::path& socketPath, const std::vector<std::wstring>& javacArgs );
+}
+
+#endif // Header guard
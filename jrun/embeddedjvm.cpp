@@ -0,0 +1,438 @@
+/// Denom.org
+///
+/// MIT No Attribution.
+///
+/// Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software
+/// without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+/// permit persons to whom the Software is furnished to do so.
+///
+/// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+/// PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+/// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+///
+/// Author:  Sergey Novochenko,  Digrol@gmail.com
+///
+/// JVM loaded into jrun process: compile and run programme without starting 'javac' and 'java'.
+
+#include <string>
+#include <vector>
+#include <thread>
+#include <exception>
+#include <stdint.h>
+#include "utils.h"
+#include "exception.h"
+#include "metrics.h"
+#include "trace.h"
+#include "embeddedjvm.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <signal.h>
+#include <dlfcn.h>
+#endif
+
+namespace fs = std::filesystem;
+using std::string;
+using std::wstring;
+using std::vector;
+using namespace Denom;
+
+namespace {
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Part of JNI, which is used here. libjvm is loaded at runtime, so jni.h of JDK is not needed for build.
+// Indexes of functions in JNIEnv and JavaVM tables are fixed by JNI specification.
+
+#if defined( _WIN32 ) && !defined( _WIN64 )
+	#define JNICALL __stdcall
+#else
+	#define JNICALL
+#endif
+
+typedef int32_t jint;
+typedef void* jobject;
+typedef void* jclass;
+typedef void* jmethodID;
+
+union jvalue
+{
+	jint i;
+	int64_t j;
+	double d;
+	jobject l;
+};
+
+struct JavaVMOption
+{
+	const char* optionString;
+	void* extraInfo;
+};
+
+struct JavaVMInitArgs
+{
+	jint version;
+	jint nOptions;
+	JavaVMOption* options;
+	uint8_t ignoreUnrecognized;
+};
+
+const jint JNI_OK = 0;
+const jint JNI_VERSION_9 = 0x00090000;
+
+typedef jint (JNICALL *CreateJavaVM)( void** vm, void** env, void* args );
+
+enum JavaVMFunction : size_t
+{
+	DESTROY_JAVA_VM = 3
+};
+
+enum JNIEnvFunction : size_t
+{
+	FIND_CLASS                  = 6,
+	EXCEPTION_DESCRIBE          = 16,
+	EXCEPTION_CLEAR             = 17,
+	DELETE_LOCAL_REF            = 23,
+	NEW_OBJECT_A                = 30,
+	GET_METHOD_ID               = 33,
+	CALL_OBJECT_METHOD_A        = 36,
+	CALL_INT_METHOD_A           = 51,
+	CALL_VOID_METHOD_A          = 63,
+	GET_STATIC_METHOD_ID        = 113,
+	CALL_STATIC_OBJECT_METHOD_A = 116,
+	CALL_STATIC_VOID_METHOD_A   = 143,
+	NEW_STRING                  = 163,
+	NEW_OBJECT_ARRAY            = 172,
+	SET_OBJECT_ARRAY_ELEMENT    = 174,
+	EXCEPTION_CHECK             = 228
+};
+
+// ---------------------------------------------------------------------------------------------------------------------
+/// Call function number 'index' of JNI table 'iface' (JNIEnv* or JavaVM*), which is pointer to pointer to table.
+template< typename R, typename... Args >
+R callJni( void* iface, size_t index, Args... args )
+{
+	typedef R (JNICALL *Function)( void*, Args... );
+	return ((Function)( (*(void***)iface)[ index ] ))( iface, args... );
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+/// Wrapper of JNIEnv: lookups throw Denom::Exception if class or method is not found.
+class Jni
+{
+public:
+	explicit Jni( void* env ) : env( env ) {}
+
+	/// Print pending Java exception to stderr and clear it.
+	/// @return true if there was exception.
+	bool describeException()
+	{
+		if( !callJni<uint8_t>( env, EXCEPTION_CHECK ) )
+			return false;
+		callJni<void>( env, EXCEPTION_DESCRIBE );
+		return true;
+	}
+
+	/// Clear pending Java exception, which is expected.
+	/// @return true if there was exception.
+	bool clearException()
+	{
+		if( !callJni<uint8_t>( env, EXCEPTION_CHECK ) )
+			return false;
+		callJni<void>( env, EXCEPTION_CLEAR );
+		return true;
+	}
+
+	/// Throws Denom::Exception, if Java exception is pending or 'result' is null.
+	void check( const void* result, const char* what )
+	{
+		bool failed = describeException();
+		MUST_M( !failed && result, L"JNI: " + s2w( what ) + L" failed" );
+	}
+
+	/// @param name - in internal form, e.g. "java/lang/String".
+	jclass findClass( const char* name )
+	{
+		jclass cls = callJni<jclass>( env, FIND_CLASS, name );
+		check( cls, name );
+		return cls;
+	}
+
+	jmethodID method( jclass cls, const char* name, const char* signature )
+	{
+		jmethodID id = callJni<jmethodID>( env, GET_METHOD_ID, cls, name, signature );
+		check( id, name );
+		return id;
+	}
+
+	jmethodID staticMethod( jclass cls, const char* name, const char* signature )
+	{
+		jmethodID id = callJni<jmethodID>( env, GET_STATIC_METHOD_ID, cls, name, signature );
+		check( id, name );
+		return id;
+	}
+
+	jobject newObject( const char* className, const char* ctorSignature, const jvalue* args )
+	{
+		jclass cls = findClass( className );
+		jobject obj = callJni<jobject>( env, NEW_OBJECT_A, cls, method( cls, "<init>", ctorSignature ), args );
+		check( obj, className );
+		return obj;
+	}
+
+	/// Call method of 'obj', which returns object.
+	jobject callObject( jobject obj, jclass cls, const char* name, const char* signature, const jvalue* args )
+	{
+		jobject result = callJni<jobject>( env, CALL_OBJECT_METHOD_A, obj, method( cls, name, signature ), args );
+		check( result, name );
+		return result;
+	}
+
+	jobject callStaticObject( jclass cls, const char* name, const char* signature, const jvalue* args )
+	{
+		jobject result = callJni<jobject>( env, CALL_STATIC_OBJECT_METHOD_A, cls, staticMethod( cls, name, signature ), args );
+		check( result, name );
+		return result;
+	}
+
+	/// String is passed in UTF-16: NewStringUTF expects modified UTF-8, which differs from UTF-8 in '\0' and in
+	/// characters beyond BMP.
+	jobject newString( const wstring& str )
+	{
+		std::u16string utf16;
+		utf16.reserve( str.size() );
+		for( wchar_t ch : str )
+		{
+			uint32_t c = (uint32_t)ch;
+			if( c >= 0x10000 )
+			{
+				// Surrogate pair: wchar_t is UTF-32 on Linux; on Windows it is UTF-16 already and never gets here
+				c -= 0x10000;
+				utf16 += (char16_t)(0xD800 + (c >> 10));
+				utf16 += (char16_t)(0xDC00 + (c & 0x3FF));
+			}
+			else
+			{
+				utf16 += (char16_t)c;
+			}
+		}
+		jobject result = callJni<jobject>( env, NEW_STRING, (const uint16_t*)utf16.data(), (jint)utf16.size() );
+		check( result, "NewString" );
+		return result;
+	}
+
+	jobject newStringArray( const vector<wstring>& strings )
+	{
+		jobject array = callJni<jobject>( env, NEW_OBJECT_ARRAY, (jint)strings.size(), findClass( "java/lang/String" ),
+			(jobject)nullptr );
+		check( array, "NewObjectArray" );
+		for( size_t i = 0; i < strings.size(); ++i )
+		{
+			jobject str = newString( strings[ i ] );
+			callJni<void>( env, SET_OBJECT_ARRAY_ELEMENT, array, (jint)i, str );
+			callJni<void>( env, DELETE_LOCAL_REF, str );
+		}
+		return array;
+	}
+
+	void* env;
+};
+
+// ---------------------------------------------------------------------------------------------------------------------
+EmbeddedJvm::ExitHook exitHook = nullptr;
+
+void JNICALL onJvmExit( jint code )
+{
+	if( exitHook )
+		exitHook( code );
+}
+
+} // namespace
+
+// ---------------------------------------------------------------------------------------------------------------------
+EmbeddedJvm::EmbeddedJvm( const Jdk& jdk, ExitHook hook )
+{
+	TraceSpan span( "createJvm" );
+	const fs::path& libjvm = jdk.libjvm;
+	MUST_M( !libjvm.empty(), L"JVM library not found in JDK of " + fromPath( jdk.java ) );
+	CreateJavaVM createJavaVM = nullptr;
+
+	#ifdef _WIN32
+		HMODULE module = LoadLibraryW( fromPath( libjvm ).c_str() );
+		MUST_M( module, L"Can't load " + fromPath( libjvm ) );
+		library = module;
+		createJavaVM = (CreateJavaVM)GetProcAddress( module, "JNI_CreateJavaVM" );
+	#else
+		library = dlopen( libjvm.c_str(), RTLD_NOW | RTLD_GLOBAL );
+		if( !library )
+		{
+			const char* error = dlerror();
+			THROW_M( L"Can't load " + fromPath( libjvm ) + L": " + s2w( error ? error : "" ) );
+		}
+		createJavaVM = (CreateJavaVM)dlsym( library, "JNI_CreateJavaVM" );
+
+		// JVM installs its own handlers only over default ones: Ctrl+C must run shutdown hooks of programme,
+		// and SIGSEGV is used by JVM itself.
+		signal( SIGINT,  SIG_DFL );
+		signal( SIGTERM, SIG_DFL );
+		signal( SIGSEGV, SIG_DFL );
+		signal( SIGABRT, SIG_DFL );
+	#endif
+	MUST_M( createJavaVM, L"JNI_CreateJavaVM not found in " + fromPath( libjvm ) );
+
+	exitHook = hook;
+	JavaVMOption options[] = { { "exit", (void*)&onJvmExit } };
+	JavaVMInitArgs initArgs;
+	initArgs.version = JNI_VERSION_9;
+	initArgs.nOptions = sizeof( options ) / sizeof( options[ 0 ] );
+	initArgs.options = options;
+	initArgs.ignoreUnrecognized = 0;
+
+	jint code = createJavaVM( &vm, &env, &initArgs );
+	MUST_M( code == JNI_OK, L"Can't create JVM from " + fromPath( libjvm ) + L", error " + std::to_wstring( code ) );
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+EmbeddedJvm::~EmbeddedJvm()
+{
+	// libjvm is not unloaded: JVM does not support it
+	if( vm )
+		callJni<jint>( vm, DESTROY_JAVA_VM );
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+int EmbeddedJvm::compile( const vector<wstring>& javacArgs )
+{
+	static Counter& embedded = Metrics::counter( "javac.embedded" );
+	embedded.add();
+	Jni jni( env );
+	jclass provider = jni.findClass( "javax/tools/ToolProvider" );
+	jobject compiler = callJni<jobject>( env, CALL_STATIC_OBJECT_METHOD_A, provider,
+		jni.staticMethod( provider, "getSystemJavaCompiler", "()Ljavax/tools/JavaCompiler;" ), (const jvalue*)nullptr );
+	jni.describeException();
+	MUST_M( compiler, L"javax.tools.JavaCompiler is not available: JVM is not from JDK" );
+
+	// Tool.run( in, out, err, args ): null streams are System.in/out/err
+	jvalue args[ 4 ] = {};
+	args[ 3 ].l = jni.newStringArray( javacArgs );
+	jclass tool = jni.findClass( "javax/tools/Tool" );
+	jint code = callJni<jint>( env, CALL_INT_METHOD_A, compiler,
+		jni.method( tool, "run", "(Ljava/io/InputStream;Ljava/io/OutputStream;Ljava/io/OutputStream;[Ljava/lang/String;)I" ),
+		(const jvalue*)args );
+	if( jni.describeException() )
+		return 1;
+	return code;
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+bool EmbeddedJvm::loadMain( const fs::path& classesDir, const wstring& mainClass )
+{
+	Jni jni( env );
+	this->mainClass = nullptr;
+
+	// new File( classesDir ).toURI().toURL()
+	jvalue arg[ 2 ] = {};
+	arg[ 0 ].l = jni.newString( fromPath( classesDir ) );
+	jobject file = jni.newObject( "java/io/File", "(Ljava/lang/String;)V", arg );
+	jobject uri = jni.callObject( file, jni.findClass( "java/io/File" ), "toURI", "()Ljava/net/URI;", nullptr );
+	jobject url = jni.callObject( uri, jni.findClass( "java/net/URI" ), "toURL", "()Ljava/net/URL;", nullptr );
+
+	jobject urls = callJni<jobject>( env, NEW_OBJECT_ARRAY, (jint)1, jni.findClass( "java/net/URL" ), url );
+	jni.check( urls, "NewObjectArray" );
+
+	// Parent is platform loader, not system one: default class path of embedded JVM is current directory,
+	// classes from it must not shadow classes of programme.
+	jclass classLoader = jni.findClass( "java/lang/ClassLoader" );
+	arg[ 0 ].l = urls;
+	arg[ 1 ].l = jni.callStaticObject( classLoader, "getPlatformClassLoader", "()Ljava/lang/ClassLoader;", nullptr );
+	jobject loader = jni.newObject( "java/net/URLClassLoader", "([Ljava/net/URL;Ljava/lang/ClassLoader;)V", arg );
+
+	jclass threadClass = jni.findClass( "java/lang/Thread" );
+	jobject thread = jni.callStaticObject( threadClass, "currentThread", "()Ljava/lang/Thread;", nullptr );
+	arg[ 0 ].l = loader;
+	callJni<void>( env, CALL_VOID_METHOD_A, thread,
+		jni.method( threadClass, "setContextClassLoader", "(Ljava/lang/ClassLoader;)V" ), (const jvalue*)arg );
+	jni.check( thread, "setContextClassLoader" );
+
+	setProperty( L"java.class.path", fromPath( classesDir ) );
+
+	// loadClass and getMethod don't initialize class: nothing of programme runs, if it is left to 'java'
+	arg[ 0 ].l = jni.newString( mainClass );
+	jclass cls = callJni<jclass>( env, CALL_OBJECT_METHOD_A, loader,
+		jni.method( classLoader, "loadClass", "(Ljava/lang/String;)Ljava/lang/Class;" ), (const jvalue*)arg );
+	if( jni.clearException() || !cls )
+		return false;
+
+	jclass classClass = jni.findClass( "java/lang/Class" );
+	jclass stringArray = jni.findClass( "[Ljava/lang/String;" );
+	jobject params = callJni<jobject>( env, NEW_OBJECT_ARRAY, (jint)1, classClass, stringArray );
+	jni.check( params, "NewObjectArray" );
+	arg[ 0 ].l = jni.newString( L"main" );
+	arg[ 1 ].l = params;
+	jobject main = callJni<jobject>( env, CALL_OBJECT_METHOD_A, cls,
+		jni.method( classClass, "getMethod", "(Ljava/lang/String;[Ljava/lang/Class;)Ljava/lang/reflect/Method;" ),
+		(const jvalue*)arg );
+	if( jni.clearException() || !main )
+		return false; // instance main() or main() without parameters of JDK 21+
+
+	jint modifiers = callJni<jint>( env, CALL_INT_METHOD_A, main,
+		jni.method( jni.findClass( "java/lang/reflect/Method" ), "getModifiers", "()I" ), (const jvalue*)nullptr );
+	jni.check( main, "getModifiers" );
+	const jint STATIC = 0x0008; // java.lang.reflect.Modifier.STATIC
+	if( (modifiers & STATIC) == 0 )
+		return false;
+
+	this->mainClass = cls;
+	return true;
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+int EmbeddedJvm::runMain( const vector<wstring>& args )
+{
+	MUST_M( mainClass, L"Main class is not loaded" );
+	Jni jni( env );
+	jmethodID main = jni.staticMethod( mainClass, "main", "([Ljava/lang/String;)V" );
+
+	jvalue arg[ 1 ] = {};
+	arg[ 0 ].l = jni.newStringArray( args );
+	callJni<void>( env, CALL_STATIC_VOID_METHOD_A, mainClass, main, (const jvalue*)arg );
+	return jni.describeException() ? 1 : 0;
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+void EmbeddedJvm::setProperty( const wstring& name, const wstring& value )
+{
+	Jni jni( env );
+	jclass system = jni.findClass( "java/lang/System" );
+	jvalue args[ 2 ] = {};
+	args[ 0 ].l = jni.newString( name );
+	args[ 1 ].l = jni.newString( value );
+	// Returns previous value, which can be null
+	callJni<jobject>( env, CALL_STATIC_OBJECT_METHOD_A, system,
+		jni.staticMethod( system, "setProperty", "(Ljava/lang/String;Ljava/lang/String;)Ljava/lang/String;" ),
+		(const jvalue*)args );
+	jni.check( system, "setProperty" );
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+int EmbeddedJvm::runInNewThread( const std::function<int()>& func )
+{
+	int result = 0;
+	std::exception_ptr error;
+	std::thread thread( [&]()
+	{
+		try
+		{
+			result = func();
+		}
+		catch( ... )
+		{
+			error = std::current_exception();
+		}
+	} );
+	thread.join();
+
+	if( error )
+		std::rethrow_exception( error );
+	return result;
+}
@@ -0,0 +1,77 @@
+/// Denom.org
+///
+/// MIT No Attribution.
+///
+/// Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software
+/// without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+/// permit persons to whom the Software is furnished to do so.
+///
+/// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+/// PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+/// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+///
+/// Author:  Sergey Novochenko,  Digrol@gmail.com
+///
+/// JVM loaded into jrun process: compile and run programme without starting 'javac' and 'java'.
+
+#ifndef EMBEDDEDJVM_H_6B2E94D1F07A3C58
+#define EMBEDDEDJVM_H_6B2E94D1F07A3C58
+
+#include <string>
+#include <vector>
+#include <functional>
+#include <filesystem>
+#include "jdk.h"
+
+// ---------------------------------------------------------------------------------------------------------------------
+/// Loads libjvm of JDK and creates JVM by JNI_CreateJavaVM. Sources are compiled by javax.tools in this JVM,
+/// then main class is loaded by new class loader and invoked in the same JVM, so uncached run pays JVM start once.
+/// Requires JDK 9+ (libjvm in lib/server, javac in module jdk.compiler).
+/// Only one JVM per process: JNI does not allow to create JVM again after it is destroyed.
+/// Methods must be called from the thread, which has created object.
+class EmbeddedJvm
+{
+public:
+	/// Called on System.exit() of programme; process exits after hook returns, or hook may end it by _exit.
+	typedef void (*ExitHook)( int code );
+
+	/// Loads libjvm near 'jdk.java' and creates JVM in calling thread.
+	/// Throws Denom::Exception if libjvm is not found or JVM can't be created.
+	explicit EmbeddedJvm( const Jdk& jdk, ExitHook exitHook = nullptr );
+
+	/// Waits for non-daemon threads of programme and destroys JVM, as 'java' does after main() returns.
+	~EmbeddedJvm();
+
+	EmbeddedJvm( const EmbeddedJvm& ) = delete;
+	EmbeddedJvm& operator=( const EmbeddedJvm& ) = delete;
+
+	/// Compile by javax.tools.JavaCompiler, diagnostics are printed to stderr.
+	/// @param javacArgs - arguments of javac, without executable.
+	/// @return exit code of javac.
+	int compile( const std::vector<std::wstring>& javacArgs );
+
+	/// Load 'mainClass' from 'classesDir' for 'runMain', without initialization; java.class.path = 'classesDir'.
+	/// @return false if class is not found or has no 'public static void main(String[])' - e.g. instance main()
+	/// of JDK 21+, which only 'java' runs.
+	bool loadMain( const std::filesystem::path& classesDir, const std::wstring& mainClass );
+
+	/// Invoke main( args ) of class, loaded by 'loadMain'.
+	/// @return 0, or 1 if main() has thrown exception (it is printed to stderr, like 'java' does).
+	int runMain( const std::vector<std::wstring>& args );
+
+	/// System.setProperty( name, value ).
+	void setProperty( const std::wstring& name, const std::wstring& value );
+
+	/// Run 'func' in new thread and wait for it; exception of 'func' is rethrown.
+	/// JVM must not be created in the primordial thread: its stack has no guard pages for the JVM stack banging
+	/// ('java' also starts JVM in a new thread).
+	static int runInNewThread( const std::function<int()>& func );
+
+private:
+	void* library = nullptr;
+	void* vm = nullptr;  // JavaVM*
+	void* env = nullptr; // JNIEnv* of creating thread
+	void* mainClass = nullptr; // jclass, loaded by 'loadMain'
+};
+
+#endif // Header guard
@@ -0,0 +1,179 @@
+/// Denom.org
+///
+/// MIT No Attribution.
+///
+/// Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software
+/// without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+/// permit persons to whom the Software is furnished to do so.
+///
+/// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+/// PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+/// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+///
+/// Author:  Sergey Novochenko,  Digrol@gmail.com
+///
+/// Search of installed JDK.
+
+#include <string>
+#include <vector>
+#include <cstdlib>
+#include "utils.h"
+#include "exception.h"
+#include "trace.h"
+#include "binary.h"
+#include "jdk.h"
+
+namespace fs = std::filesystem;
+using std::string;
+using std::wstring;
+using namespace Denom;
+
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#ifdef _WIN32
+	static const wchar_t PATH_SEPARATOR = L';';
+	static const wchar_t* const EXE_SUFFIX = L".exe";
+#else
+	static const wchar_t PATH_SEPARATOR = L':';
+	static const wchar_t* const EXE_SUFFIX = L"";
+#endif
+
+// ---------------------------------------------------------------------------------------------------------------------
+/// @return true if 'dir' contains executable 'name' (with extension on Windows).
+static bool findExe( const fs::path& dir, const wstring& name, fs::path& result )
+{
+	if( dir.empty() )
+		return false;
+
+	std::error_code ec;
+	fs::path candidate = dir / toPath( name + EXE_SUFFIX );
+	if( !fs::is_regular_file( candidate, ec ) )
+		return false;
+
+	result = fs::canonical( candidate, ec );
+	return !ec;
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+static fs::path findJavac()
+{
+	fs::path javac;
+
+	wstring javaHome = getEnv( L"JAVA_HOME" );
+	if( !javaHome.empty() && findExe( toPath( javaHome ) / "bin", L"javac", javac ) )
+		return javac;
+
+	wstring pathVar = getEnv( L"PATH" );
+	size_t start = 0;
+	while( start <= pathVar.size() )
+	{
+		size_t end = pathVar.find( PATH_SEPARATOR, start );
+		if( end == wstring::npos )
+			end = pathVar.size();
+
+		if( findExe( toPath( pathVar.substr( start, end - start ) ), L"javac", javac ) )
+			return javac;
+		start = end + 1;
+	}
+
+	THROW_M( L"Can't find 'javac'. Set JAVA_HOME or add JDK to PATH" );
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+/// Value from <java.home>/release: KEY="value".
+/// @return empty string if not found.
+static string releaseValue( const string& release, const string& key )
+{
+	string prefix = key + "=\"";
+	size_t pos = 0;
+	while( (pos = release.find( prefix, pos )) != string::npos )
+	{
+		if( (pos == 0) || (release[ pos - 1 ] == '\n') )
+		{
+			pos += prefix.size();
+			size_t end = release.find( '"', pos );
+			return release.substr( pos, (end == string::npos) ? string::npos : end - pos );
+		}
+		pos += prefix.size();
+	}
+	return string();
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+/// Feature version from JAVA_VERSION: "17.0.2" or "1.8.0_292".
+/// @return feature version or 0.
+static int parseVersion( const string& javaVersion )
+{
+	int version = atoi( javaVersion.c_str() );
+	if( (version == 1) && (javaVersion.compare( 0, 2, "1." ) == 0) )
+		version = atoi( javaVersion.c_str() + 2 );
+	return version;
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+/// libjvm of JDK 9+: <java.home>/lib/server (bin/server on Windows).
+/// @return empty path if JDK has no libjvm there.
+static fs::path findLibjvm( const fs::path& javaHome )
+{
+	#if defined( _WIN32 )
+		fs::path libjvm = javaHome / "bin" / "server" / "jvm.dll";
+	#elif defined( __APPLE__ )
+		fs::path libjvm = javaHome / "lib" / "server" / "libjvm.dylib";
+	#else
+		fs::path libjvm = javaHome / "lib" / "server" / "libjvm.so";
+	#endif
+	std::error_code ec;
+	return fs::is_regular_file( libjvm, ec ) ? libjvm : fs::path();
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+/// Size and modification time of 'file' by one 'stat'; zeros if it fails.
+static void getFileStamp( const fs::path& file, uint64_t& size, int64_t& mtime )
+{
+	size = 0;
+	mtime = 0;
+	#ifdef _WIN32
+		struct _stat64 st;
+		if( _wstat64( file.c_str(), &st ) == 0 )
+		{
+			size = (uint64_t)st.st_size;
+			mtime = (int64_t)st.st_mtime * 1000000000;
+		}
+	#else
+		struct stat st;
+		if( stat( file.c_str(), &st ) == 0 )
+		{
+			size = (uint64_t)st.st_size;
+			#ifdef __APPLE__
+				mtime = (int64_t)st.st_mtimespec.tv_sec * 1000000000 + st.st_mtimespec.tv_nsec;
+			#else
+				mtime = (int64_t)st.st_mtim.tv_sec * 1000000000 + st.st_mtim.tv_nsec;
+			#endif
+		}
+	#endif
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+Jdk findJdk()
+{
+	TraceSpan span( "findJdk" );
+	Jdk jdk;
+	jdk.javac = findJavac();
+
+	// 'java' from the same JDK as 'javac'
+	MUST_M( findExe( jdk.javac.parent_path(), L"java", jdk.java ),
+		L"Can't find 'java' near " + fromPath( jdk.javac ) );
+
+	uint64_t size;
+	int64_t mtime;
+	getFileStamp( jdk.javac, size, mtime );
+	jdk.identity = w2s( fromPath( jdk.javac ) ) + "|" + std::to_string( size ) + "|" + std::to_string( mtime );
+
+	fs::path javaHome = jdk.javac.parent_path().parent_path();
+	Binary release;
+	if( release.tryLoadFromFile( (javaHome / "release").native() ) )
+		jdk.version = parseVersion( releaseValue( string( release.begin(), release.end() ), "JAVA_VERSION" ) );
+	jdk.libjvm = findLibjvm( javaHome );
+	return jdk;
+}
@@ -0,0 +1,46 @@
+/// Denom.org
+///
+/// MIT No Attribution.
+///
+/// Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software
+/// without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+/// permit persons to whom the Software is furnished to do so.
+///
+/// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+/// PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+/// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+///
+/// Author:  Sergey Novochenko,  Digrol@gmail.com
+///
+/// Search of installed JDK.
+
+#ifndef JDK_H_4E1F9A0C2B7D6358
+#define JDK_H_4E1F9A0C2B7D6358
+
+#include <string>
+#include <filesystem>
+
+// ---------------------------------------------------------------------------------------------------------------------
+/// Executables of JDK, used for compiling and running programmes.
+struct Jdk
+{
+	std::filesystem::path javac;
+	std::filesystem::path java;
+
+	/// Identifies JDK build: real path of 'javac', its size and modification time.
+	/// Part of compile cache key - any JDK update invalidates cached classes.
+	std::string identity;
+
+	/// Feature version: 8, 11, 17... 0 if unknown.
+	int version = 0;
+
+	/// JVM library for embedding (see EmbeddedJvm), empty if JDK has none.
+	std::filesystem::path libjvm;
+};
+
+// ---------------------------------------------------------------------------------------------------------------------
+/// Find JDK: at first in JAVA_HOME, then in PATH.
+/// Throws Denom::Exception if 'javac' not found.
+Jdk findJdk();
+
+#endif // Header guard
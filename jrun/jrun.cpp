@@ -17,12 +17,29 @@
 #include <string>
 #include <vector>
 #include <locale>
+#include <cwchar>
+#include <cstdlib>
+#include <cerrno>
+#include <atomic>
 #include <signal.h>
 #include "log.h"
+#include "logger.h"
 #include "utils.h"
 #include "binary.h"
 #include "exception.h"
+#include "metrics.h"
+#include "trace.h"
+#include "sha256.h"
+#include "childprocess.h"
+#include "jdk.h"
+#include "cache.h"
+#include "classarchive.h"
+#include "compileserver.h"
+#include "embeddedjvm.h"
+#include "jvmpool.h"
+#include <memory>
 
+namespace fs = std::filesystem;
 using std::vector;
 using std::string;
 using std::wstring;
@@ -31,15 +48,25 @@ using namespace Denom;
 // ---------------------------------------------------------------------------------------------------------------------
 static void printUsage()
 {
-	Console::println( L"Usage:  jrun.exe <java-filename>" );
+	Console::println( L"Usage:  jrun [options] <java-filename> [programme arguments]" );
+	Console::println( L"Options:" );
+	Console::println( L"  --in-process      compile and run in one JVM, loaded into jrun (JDK 9+)" );
+	Console::println( L"  --server          run compile server: warm javac for other launches (JDK 16+, not on Windows)" );
+	Console::println( L"  --pool <N>        run pool of N started JVMs for other launches (JDK 9+, not on Windows)" );
+	Console::println( L"  --use-pool        run programme by JVM of running pool, if it can; else by 'java'" );
+	Console::println( L"  --metrics=<file>  write metrics (bytes read, cache hits, durations) to JSON file at exit" );
+	Console::println( L"  --self-test       check implementations of SHA-256, chosen for this CPU" );
+	Console::println( L"Environment:" );
+	Console::println( L"  JRUN_TRACE=<file>  write trace of launch phases (Chrome trace event format) to file" );
+	Console::println( L"  JRUN_BACKTRACE=1   print call stack of jrun errors" );
 }
 
 // ---------------------------------------------------------------------------------------------------------------------
 static void OnInvalidParameterInCRT( const wchar_t* expression, const wchar_t* function,
 	const wchar_t* file, unsigned int line, uintptr_t pReserved )
 {
-	Console::println( L"Invalid parameter in function %s.\nFile: %s Line: %d\n", function, file, line );
-	Console::println( L"Expression: %s\n", expression );
+	Console::println( FMT( "Invalid parameter in function {}.\nFile: {} Line: {}\n" ), function, file, line );
+	Console::println( FMT( "Expression: {}\n" ), expression );
 	exit(1);
 }
 
@@ -51,19 +78,398 @@ static void SignalHandler( int signal )
 }
 
 // ---------------------------------------------------------------------------------------------------------------------
-int Main( const vector<wstring>& args )
+/// Child process, which jrun waits for (pid); signal, which has come before it was started.
+static std::atomic<intptr_t> childId( 0 );
+static std::atomic<int> pendingSignal( 0 );
+
+static void forwardToChild( int signal )
+{
+	intptr_t id = childId;
+	if( id == 0 )
+		pendingSignal = signal;
+	#ifndef _WIN32
+	else
+		kill( (pid_t)id, signal );
+	#endif
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+/// Run 'process' and wait for it. Meanwhile SIGINT is ignored - Ctrl+C comes to child from terminal itself,
+/// SIGTERM is forwarded to child. So jrun returns exit code of child and completes its work, e.g. CDS archive.
+static int runChild( Process& process )
 {
-// 	for( int i = 0; i < args.size(); ++i )
-// 		Console::println( COLOR_GREEN, L"Аргумент %d: %ls", i, args[ i ].c_str() );
+	struct Handlers
+	{
+		void (*interrupt)( int ) = signal( SIGINT, SIG_IGN );
+		void (*terminate)( int ) = signal( SIGTERM, forwardToChild );
+		~Handlers()
+		{
+			childId = 0;
+			pendingSignal = 0;
+			signal( SIGINT, interrupt );
+			signal( SIGTERM, terminate );
+		}
+	} handlers;
 
-	Binary b;
-	b.loadFromFile( args[ 1 ] );
-	wstring ws = args[ 1 ] + L".копия";
-	b.saveToFile( ws );
-//	Console::println( b.Hex() );
+	process.start();
+	childId = process.getId();
+	int pending = pendingSignal.exchange( 0 );
+	if( pending != 0 )
+		forwardToChild( pending );
+	return process.wait();
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+/// Options for 'javac': default ones and from environment variable JRUN_JAVAC_FLAGS (separated by spaces).
+static vector<wstring> getCompilerFlags()
+{
+	vector<wstring> flags = { L"-encoding", L"UTF-8" };
+
+	wstring env = getEnv( L"JRUN_JAVAC_FLAGS" );
+	size_t pos = 0;
+	while( (pos = env.find_first_not_of( L" \t", pos )) != wstring::npos )
+	{
+		size_t end = env.find_first_of( L" \t", pos );
+		if( end == wstring::npos )
+			end = env.size();
+		flags.push_back( env.substr( pos, end - pos ) );
+		pos = end;
+	}
+	return flags;
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+/// Main class has the same name as the source file and is placed in the package, declared in source.
+/// Example: "package org.denom.tools;" + "Hello.java"  ->  "org.denom.tools.Hello".
+static wstring getMainClass( const Binary& source, const string& sourceFile )
+{
+	wstring className = fromPath( fs::path( toNative( sourceFile ) ).stem() );
+
+	string text( source.begin(), source.end() );
+	size_t lineStart = 0;
+	while( lineStart < text.size() )
+	{
+		size_t lineEnd = text.find( '\n', lineStart );
+		if( lineEnd == string::npos )
+			lineEnd = text.size();
+
+		size_t pos = text.find_first_not_of( " \t\r\xEF\xBB\xBF", lineStart );
+		if( (pos != string::npos) && (pos < lineEnd) )
+		{
+			if( text.compare( pos, 8, "package " ) == 0 )
+			{
+				size_t nameStart = text.find_first_not_of( " \t", pos + 8 );
+				size_t nameEnd = text.find( ';', nameStart );
+				MUST_M( (nameStart < lineEnd) && (nameEnd < lineEnd),
+					L"Wrong 'package' declaration in " + s2w( sourceFile ) );
+				string package = text.substr( nameStart, nameEnd - nameStart );
+				package.erase( package.find_last_not_of( " \t" ) + 1 );
+				return s2w( package ) + L"." + className;
+			}
+
+			// Package declaration can be preceded only by comments
+			bool isComment = (text.compare( pos, 2, "//" ) == 0) || (text.compare( pos, 2, "/*" ) == 0)
+				|| (text[ pos ] == '*');
+			if( !isComment )
+				break;
+		}
+		lineStart = lineEnd + 1;
+	}
+	return className;
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+/// Options of jrun itself, placed before java-filename.
+struct Options
+{
+	wstring metricsFile;
+	bool server = false;
+	bool inProcess = false;
+	bool selfTest = false;
+	bool usePool = false;
+	int poolSize = 0;
+};
+
+static Options options;
+
+// ---------------------------------------------------------------------------------------------------------------------
+/// Parses options and removes them from 'params'.
+static Options parseOptions( vector<string>& params )
+{
+	Options options;
+	size_t i = 1;
+	for( ; (i < params.size()) && (params[ i ].compare( 0, 2, "--" ) == 0); ++i )
+	{
+		const string& param = params[ i ];
+		if( param == "--server" )
+		{
+			options.server = true;
+		}
+		else if( param == "--in-process" )
+		{
+			options.inProcess = true;
+		}
+		else if( param == "--self-test" )
+		{
+			options.selfTest = true;
+		}
+		else if( param == "--use-pool" )
+		{
+			options.usePool = true;
+		}
+		else if( param == "--pool" )
+		{
+			MUST_M( i + 1 < params.size(), L"Size is missing in option: " + s2w( param ) );
+			options.poolSize = (int)std::strtol( params[ ++i ].c_str(), nullptr, 10 );
+			MUST_M( options.poolSize > 0, L"Invalid size of JVM pool: " + s2w( params[ i ] ) );
+		}
+		else if( param.compare( 0, 10, "--metrics=" ) == 0 )
+		{
+			options.metricsFile = s2w( param.substr( 10 ) );
+			MUST_M( !options.metricsFile.empty(), L"File name is missing in option: " + s2w( param ) );
+		}
+		else
+		{
+			THROW_M( L"Unknown option: " + s2w( param ) );
+		}
+	}
+	params.erase( params.begin() + 1, params.begin() + i );
+	return options;
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+/// Compile by embedded JVM if 'jvm' is given, else by compile server if it is running, otherwise by javac.
+/// @return exit code of javac; error if compile server has not answered in time - it can still write classes.
+static Expected<int> runJavac( const Jdk& jdk, const CompileCache& cache, EmbeddedJvm* jvm,
+	const vector<wstring>& javacArgs, bool useServer )
+{
+	static LatencyHistogram& compileTime = Metrics::histogram( "javac.durationNs" );
+	TraceSpan span( "javac" );
+	ScopedTimer timer( compileTime );
+
+	if( jvm )
+		return jvm->compile( javacArgs );
+
+	if( useServer )
+	{
+		Expected<int> served = CompileServer::compile( CompileServer::socketPath( cache.getRoot(), jdk ), javacArgs );
+		if( served || (served.error().sysError == ETIMEDOUT) )
+			return served;
+	}
+
+	vector<wstring> args = { fromPath( jdk.javac ) };
+	args.insert( args.end(), javacArgs.begin(), javacArgs.end() );
+	Process javac( args );
+	return runChild( javac );
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+/// Compile 'sourceFile' into new cache entry.
+/// @param jvm - embedded JVM or nullptr.
+/// @param classesDir - directory of cache entry, if compiled successfully.
+/// @return exit code of javac.
+static int compileToCache( const Jdk& jdk, const CompileCache& cache, EmbeddedJvm* jvm, const Binary& key,
+	const vector<wstring>& flags, const fs::path& sourceFile, fs::path& classesDir )
+{
+	TraceSpan span( "compile" );
+	// Only the hashed source is compiled: empty source path excludes sibling sources from current directory and
+	// CLASSPATH, class path excludes classes, which are not on class path of 'java'.
+	auto makeArgs = [&]( const fs::path& outputDir )
+	{
+		vector<wstring> javacArgs = { L"-sourcepath", L"", L"-cp", fromPath( outputDir ) };
+		javacArgs.insert( javacArgs.end(), flags.begin(), flags.end() );
+		javacArgs.push_back( L"-d" );
+		javacArgs.push_back( fromPath( outputDir ) );
+		javacArgs.push_back( fromPath( sourceFile ) );
+		return javacArgs;
+	};
+
+	fs::path stagingDir = cache.createStagingDir( key );
+	Expected<int> compiled = runJavac( jdk, cache, jvm, makeArgs( stagingDir ), true );
+	if( !compiled )
+	{
+		// Hung compile server can still write into staging directory: javac compiles into new one
+		cache.discard( stagingDir );
+		stagingDir = cache.createStagingDir( key );
+		compiled = runJavac( jdk, cache, jvm, makeArgs( stagingDir ), false );
+	}
+
+	int code = *compiled;
+	if( code != 0 )
+	{
+		cache.discard( stagingDir );
+		return code;
+	}
+	classesDir = cache.commit( key, stagingDir );
 	return 0;
 }
 
+// ---------------------------------------------------------------------------------------------------------------------
+/// Compile Java part of jrun itself (compile server, warm-up of JVM pool) by the cache.
+/// @return directory with classes.
+static fs::path compileInternal( const Jdk& jdk, const CompileCache& cache, const fs::path& sourceFile )
+{
+	vector<wstring> flags = getCompilerFlags();
+	Binary source;
+	source.loadFromFile( sourceFile.native() );
+	wstring mainClass = getMainClass( source, w2s( fromPath( sourceFile ) ) );
+	Binary key = CompileCache::makeKey( source, mainClass, jdk.identity, flags );
+
+	fs::path classesDir;
+	if( !cache.find( key, classesDir ) )
+	{
+		int code = compileToCache( jdk, cache, nullptr, key, flags, sourceFile, classesDir );
+		MUST_C( code == 0, code, L"Can't compile " + fromPath( sourceFile ) );
+	}
+	return classesDir;
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+/// jrun --self-test
+static int runSelfTest()
+{
+	bool ok = sha256SelfTest();
+	Console::println( FMT( "SHA-256 ({}): {}" ), sha256ImplName(), ok ? "OK" : "FAILED" );
+	return ok ? 0 : 1;
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+/// jrun --server
+static int runServer()
+{
+	CompileCache cache;
+	Jdk jdk = findJdk();
+	fs::path classesDir = compileInternal( jdk, cache, CompileServer::writeSource( cache.getRoot() ) );
+	return CompileServer::run( jdk, classesDir, CompileServer::socketPath( cache.getRoot(), jdk ) );
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+/// jrun --pool N
+static int runPool( int size )
+{
+	CompileCache cache;
+	Jdk jdk = findJdk();
+	fs::path classesDir = compileInternal( jdk, cache, JvmPool::writeWarmUpSource( cache.getRoot() ) );
+	return JvmPool::run( jdk, classesDir, JvmPool::socketPath( cache.getRoot(), jdk ), size );
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+/// Write metrics and trace, if they are requested.
+static void saveReports()
+{
+	if( !options.metricsFile.empty() )
+	{
+		try
+		{
+			Metrics::saveJson( options.metricsFile );
+		}
+		catch( Denom::Exception& ex )
+		{
+			Console::println( FormatExceptionMessage( ex ) );
+		}
+	}
+
+	try
+	{
+		Trace::finish();
+	}
+	catch( Denom::Exception& ex )
+	{
+		Console::println( FormatExceptionMessage( ex ) );
+	}
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+/// Programme has called System.exit() in embedded JVM, process exits without return from Main.
+static void onJvmExit( int )
+{
+	saveReports();
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+int Main( const vector<string>& args )
+{
+	static LatencyHistogram& prepareTime = Metrics::histogram( "launch.prepareNs" );
+	static LatencyHistogram& runTime = Metrics::histogram( "jvm.durationNs" );
+
+	TraceSpan mainSpan( "Main" );
+	Ticker ticker;
+	// Source file name is passed to OS as is, see 'NativeName'
+	const string& sourceFile = args[ 1 ];
+
+	Binary source;
+	source.loadFromFile( sourceFile );
+	Metrics::gauge( "source.size" ).set( (int64_t)source.size() );
+
+	CompileCache cache;
+	Jdk jdk = findJdk();
+	vector<wstring> flags = getCompilerFlags();
+
+	wstring mainClass = getMainClass( source, sourceFile );
+	Binary key = CompileCache::makeKey( source, mainClass, jdk.identity, flags );
+
+	fs::path classesDir;
+	bool cached = cache.find( key, classesDir );
+	prepareTime.record( ticker.diffNs() );
+
+	std::unique_ptr<EmbeddedJvm> jvm;
+	if( options.inProcess )
+		jvm.reset( new EmbeddedJvm( jdk, onJvmExit ) );
+
+	if( !cached )
+	{
+		int code = compileToCache( jdk, cache, jvm.get(), key, flags, fs::path( toNative( sourceFile ) ), classesDir );
+		if( code != 0 )
+			return code;
+	}
+
+	// Arguments go to 'java' and to pool as they are; only JNI needs them in UTF-16
+	vector<string> programmeArgs( args.begin() + 2, args.end() );
+	TraceSpan span( "java" );
+	ScopedTimer timer( runTime );
+
+	if( jvm && jvm->loadMain( classesDir, mainClass ) )
+	{
+		vector<wstring> jniArgs;
+		for( const string& arg : programmeArgs )
+			jniArgs.push_back( s2w( arg ) );
+		int code = jvm->runMain( jniArgs );
+		jvm.reset(); // waits for threads of programme
+		return code;
+	}
+	jvm.reset(); // programme without static main(String[]) is run by 'java'
+
+	// JVM of pool has started with its own options, programme with options for start of JVM needs new one
+	bool jvmOptionsSet = !getEnv( L"JAVA_TOOL_OPTIONS" ).empty() || !getEnv( L"JDK_JAVA_OPTIONS" ).empty()
+		|| !getEnv( L"_JAVA_OPTIONS" ).empty();
+	if( options.usePool && !jvmOptionsSet )
+	{
+		Expected<int> pooled = JvmPool::launch( JvmPool::socketPath( cache.getRoot(), jdk ), classesDir, mainClass,
+			programmeArgs );
+		if( pooled )
+			return *pooled;
+	}
+
+	vector<wstring> javaArgs = { fromPath( jdk.java ) };
+	ClassArchive archive( cache.getRoot(), key );
+	if( !ClassArchive::isSupported( jdk ) || !archive.addJavaOptions( classesDir, javaArgs ) )
+	{
+		javaArgs.push_back( L"-cp" );
+		javaArgs.push_back( fromPath( classesDir ) );
+	}
+	javaArgs.push_back( mainClass );
+
+	// Nothing to do after exit of JVM: replace jrun by it, so no parent process stays in memory
+	Process java( javaArgs );
+	java.addArgs( programmeArgs );
+	if( !archive.isDumping() && options.metricsFile.empty() && !Trace::isEnabled() )
+		java.exec();
+
+	int code = runChild( java );
+	archive.complete( code );
+	return code;
+}
+
 // ---------------------------------------------------------------------------------------------------------------------
 int main( int argc, char* argv[] )
 {
@@ -81,35 +487,62 @@ int main( int argc, char* argv[] )
 	#else
 	#endif
 
+	if( !getEnv( L"JRUN_BACKTRACE" ).empty() )
+		Denom::Exception::recordCallStack = true;
+
+	wstring traceFile = getEnv( L"JRUN_TRACE" );
+	if( !traceFile.empty() )
+		Trace::start( traceFile );
+
 	int retCode = 0;
 	try
 	{
-		vector< wstring > params = convertCommandLine( argc, argv );
-		if( params.size() < 2 )
+		vector< string > params = convertCommandLineUtf8( argc, argv );
+		options = parseOptions( params );
+		if( options.selfTest )
 		{
-			printUsage();
-			exit( 1 );
+			retCode = runSelfTest();
+		}
+		else if( options.server )
+		{
+			retCode = runServer();
+		}
+		else if( options.poolSize > 0 )
+		{
+			retCode = runPool( options.poolSize );
+		}
+		else
+		{
+			if( params.size() < 2 )
+			{
+				printUsage();
+				exit( 1 );
+			}
+			if( options.inProcess )
+				retCode = EmbeddedJvm::runInNewThread( [&]() { return Main( params ); } );
+			else
+				retCode = Main( params );
 		}
-
-		retCode = Main( params );
 	}
  	catch( Denom::Exception& ex )
 	{
 		/// TODO: cross
 // 		ReduceCallStack( ex.call_stack, __FUNCTION__ );
-		Console::println( FormatExceptionMessage( ex ).c_str() );
-		return (ex.code != 0) ? ex.code : 1;
+		Log::flush(); // messages of compile server and JVM pool go first
+		Console::println( FormatExceptionMessage( ex ) );
+		retCode = (ex.code != 0) ? ex.code : 1;
 	}
 	catch( const std::exception& ex )
 	{
-		Console::println( L"Error: %ls", s2w( ex.what() ).c_str() );
-		return 1;
+		Console::println( FMT( "Error: {}" ), ex.what() );
+		retCode = 1;
 	}
 	catch ( ... )
 	{
 		Console::println( L"Unknown Error" );
-		return 1;
+		retCode = 1;
 	}
 
-	return 0;
+	saveReports();
+	return retCode;
 }
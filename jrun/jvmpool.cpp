@@ -0,0 +1,513 @@
+/// Denom.org
+///
+/// MIT No Attribution.
+///
+/// Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software
+/// without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+/// permit persons to whom the Software is furnished to do so.
+///
+/// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+/// PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+/// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+///
+/// Author:  Sergey Novochenko,  Digrol@gmail.com
+///
+/// Pool of started JVMs, which wait for programmes to run.
+
+#include <string>
+#include <vector>
+#include <set>
+#include <atomic>
+#include <cerrno>
+#include <cstdlib>
+#include <cstdio>
+#include "utils.h"
+#include "exception.h"
+#include "binary.h"
+#include "binaryspan.h"
+#include "files.h"
+#include "log.h"
+#include "logger.h"
+#include "metrics.h"
+#include "sha256.h"
+#include "localsocket.h"
+#include "embeddedjvm.h"
+#include "jvmpool.h"
+
+#ifndef _WIN32
+#include <signal.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+extern char** environ;
+#endif
+
+namespace fs = std::filesystem;
+using std::string;
+using std::wstring;
+using std::vector;
+using namespace Denom;
+
+namespace {
+
+const uint32_t MAGIC = 0x4A525031; // "JRP1"
+
+const char WARM_UP_CLASS[] = "JRunWarmUp";
+
+/// Pool, which does not start programme during this time, is considered hung: jrun runs programme itself.
+const int HANDOFF_TIMEOUT_MS = 5000;
+
+// ---------------------------------------------------------------------------------------------------------------------
+/// Runs in each worker before it waits for programme: first use of string concatenation, lambdas, collections,
+/// formatting and regular expressions costs milliseconds of bootstrap and interpretation.
+/// Must not call System.getenv(): JVM reads environment once, it must be the environment of programme.
+const char WARM_UP_SOURCE[] = R"JAVA(// Generated by jrun, see jvmpool.cpp
+import java.util.*;
+import java.util.stream.*;
+
+public class JRunWarmUp
+{
+	static volatile long sink;
+
+	public static void main( String[] args )
+	{
+		long sum = 0;
+		for( int i = 0; i < 2000; ++i )
+		{
+			String s = "item " + i + ' ' + (i * 0.5);
+			List<String> list = new ArrayList<>( List.of( s, String.valueOf( i ), s.toUpperCase() ) );
+			Map<String, Integer> map = new HashMap<>();
+			for( String e : list )
+				map.merge( e, 1, Integer::sum );
+			sum += list.stream().filter( e -> !e.isEmpty() ).mapToInt( String::length ).sum();
+			sum += map.entrySet().stream().map( Map.Entry::getKey ).collect( Collectors.joining( "," ) ).length();
+			sum += String.format( "%d %s %.2f", i, s, i / 3.0 ).length();
+			sum += s.split( " " ).length + (s.matches( "item \\d+.*" ) ? 1 : 0);
+			sum += new StringBuilder().append( s ).append( i ).reverse().length();
+		}
+		sink = sum;
+	}
+}
+)JAVA";
+
+#ifndef _WIN32
+
+// ---------------------------------------------------------------------------------------------------------------------
+/// Programme, received by worker.
+struct Request
+{
+	string cwd;
+	string classesDir;
+	string mainClass;
+	vector<string> args;
+	vector<string> env;
+};
+
+// ---------------------------------------------------------------------------------------------------------------------
+bool recvStrings( int fd, vector<string>& strings )
+{
+	uint32_t count = 0;
+	if( !LocalSocket::recvU32( fd, count ) || (count > 100000) )
+		return false;
+	strings.resize( count );
+	for( string& s : strings )
+	{
+		if( !LocalSocket::recvString( fd, s ) )
+			return false;
+	}
+	return true;
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+bool recvRequest( int fd, Request& request, int* stdFds )
+{
+	uint32_t magic = 0;
+	return LocalSocket::recvU32( fd, magic ) && (magic == MAGIC) &&
+		LocalSocket::recvString( fd, request.cwd ) &&
+		LocalSocket::recvString( fd, request.classesDir ) &&
+		LocalSocket::recvString( fd, request.mainClass ) &&
+		recvStrings( fd, request.args ) &&
+		recvStrings( fd, request.env ) &&
+		LocalSocket::recvFds( fd, stdFds, 3 );
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+/// Replace environment of worker process by environment of programme.
+void setEnvironment( const vector<string>& env )
+{
+	#ifdef __linux__
+		clearenv();
+	#else
+		while( environ && *environ )
+		{
+			string var = *environ;
+			unsetenv( var.substr( 0, var.find( '=' ) ).c_str() );
+		}
+	#endif
+	for( const string& var : env )
+	{
+		size_t eq = var.find( '=' );
+		if( (eq != string::npos) && (eq != 0) )
+			setenv( var.substr( 0, eq ).c_str(), var.c_str() + eq + 1, 1 );
+	}
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+/// Connection with client, while programme runs.
+int clientFd = -1;
+
+bool sendU32( int fd, uint32_t v )
+{
+	string buf;
+	LocalSocket::putU32( buf, v );
+	return LocalSocket::sendAll( fd, buf.data(), buf.size() );
+}
+
+/// Programme has called System.exit(); shutdown hooks of Java have run.
+/// Worker is forked from pool, which may have logger thread: static destructors must not run, so no 'exit'.
+void onProgrammeExit( int code )
+{
+	if( clientFd != -1 )
+		sendU32( clientFd, (uint32_t)code );
+	fflush( nullptr );
+	_exit( code );
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+/// Worker: starts JVM, waits for programme, runs it. Runs in thread, created for JVM.
+/// @return exit code of programme.
+/// Idle worker exits, when pool closes 'lifelineFd' or dies; worker, which has got programme, runs it to the end.
+int serve( const Jdk& jdk, const fs::path& warmUpDir, int listenFd, int notifyFd, int lifelineFd )
+{
+	int code = 1;
+	{
+		EmbeddedJvm jvm( jdk, onProgrammeExit );
+		MUST_M( jvm.loadMain( warmUpDir, s2w( WARM_UP_CLASS ) ), L"Can't load warm-up class of JVM pool" );
+		jvm.runMain( vector<wstring>() );
+
+		// Listening socket is non-blocking: other worker can accept connection first
+		int fd = -1;
+		while( fd == -1 )
+		{
+			pollfd p[ 2 ] = { { listenFd, POLLIN, 0 }, { lifelineFd, POLLIN, 0 } };
+			if( poll( p, 2, -1 ) == -1 )
+			{
+				MUST_M( errno == EINTR, L"Can't wait for connection of JVM pool" );
+				continue;
+			}
+			if( p[ 1 ].revents != 0 )
+				return 1;
+
+			fd = accept( listenFd, nullptr, nullptr );
+			if( fd == -1 )
+			{
+				MUST_M( (errno == EINTR) || (errno == EAGAIN) || (errno == EWOULDBLOCK) || (errno == ECONNABORTED),
+					L"Can't accept connection of JVM pool" );
+			}
+			else if( !LocalSocket::isPeerOwner( fd ) )
+			{
+				close( fd );
+				fd = -1;
+			}
+		}
+		close( listenFd );
+		close( lifelineFd );
+
+		// Pool starts replacement of this worker
+		int32_t pid = (int32_t)getpid();
+		ssize_t written = write( notifyFd, &pid, sizeof( pid ) );
+		(void)written;
+		close( notifyFd );
+
+		Request request;
+		int stdFds[ 3 ];
+		if( !recvRequest( fd, request, stdFds ) )
+			return 1;
+
+		// Pid 0: programme has no static main(String[]), client runs it by 'java'.
+		// Client confirms start: if it has timed out before pid came, it runs programme itself.
+		bool runnable = jvm.loadMain( toPath( s2w( request.classesDir ) ), s2w( request.mainClass ) );
+		uint32_t confirm = 0;
+		if( !sendU32( fd, runnable ? (uint32_t)pid : 0 ) || !runnable ||
+			!LocalSocket::recvU32( fd, confirm ) || (confirm != MAGIC) )
+			return 1;
+		clientFd = fd;
+
+		for( int i = 0; i < 3; ++i )
+		{
+			dup2( stdFds[ i ], i );
+			close( stdFds[ i ] );
+		}
+		MUST_M( chdir( request.cwd.c_str() ) == 0, L"Can't change directory to " + s2w( request.cwd ) );
+		setEnvironment( request.env );
+		jvm.setProperty( L"user.dir", s2w( request.cwd ) );
+
+		vector<wstring> args;
+		for( const string& arg : request.args )
+			args.push_back( s2w( arg ) );
+		code = jvm.runMain( args );
+	} // waits for threads of programme
+
+	sendU32( clientFd, (uint32_t)code );
+	return code;
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+/// Entry of worker process, after fork.
+[[noreturn]] void runWorker( const Jdk& jdk, const fs::path& warmUpDir, int listenFd, int notifyFd, int lifelineFd )
+{
+	// Without controlling terminal: programme reads and writes terminal of client, job control of
+	// terminal of pool must not stop it
+	setsid();
+	signal( SIGINT, SIG_DFL );
+	signal( SIGTERM, SIG_DFL );
+
+	int code = 1;
+	try
+	{
+		code = EmbeddedJvm::runInNewThread( [&]() { return serve( jdk, warmUpDir, listenFd, notifyFd, lifelineFd ); } );
+	}
+	catch( Denom::Exception& ex )
+	{
+		// Not LOG: writer thread of logger is not copied by fork
+		Console::println( FormatExceptionMessage( ex ) );
+	}
+	_exit( code );
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+std::atomic<bool> stopRequested( false );
+
+void onStopSignal( int )
+{
+	stopRequested = true;
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+/// Worker, which runs programme of client.
+std::atomic<pid_t> workerPid( 0 );
+
+void forwardSignal( int signal )
+{
+	pid_t pid = workerPid;
+	if( pid > 0 )
+		kill( pid, signal );
+}
+
+#endif // !_WIN32
+
+} // namespace
+
+namespace JvmPool {
+
+// ---------------------------------------------------------------------------------------------------------------------
+fs::path socketPath( const fs::path& cacheRoot, const Jdk& jdk )
+{
+	uint8_t hash[ HASH_SIZE_SHA256 ];
+	calcHashSHA256( (const uint8_t*)jdk.identity.data(), jdk.identity.size(), hash );
+	return cacheRoot / "pool" / ("jvm-" + BinarySpan( hash, 8 ).hexStr() + ".sock");
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+fs::path writeWarmUpSource( const fs::path& cacheRoot )
+{
+	fs::path dir = cacheRoot / "pool";
+	std::error_code ec;
+	fs::create_directories( dir, ec );
+	MUST_M( !ec, L"Can't create directory: " + fromPath( dir ) );
+
+	fs::path file = dir / (string( WARM_UP_CLASS ) + ".java");
+	BinarySpan source( (const uint8_t*)WARM_UP_SOURCE, sizeof( WARM_UP_SOURCE ) - 1 );
+	Binary existing;
+	if( !existing.tryLoadFromFile( file.native() ) || (BinarySpan( existing ) != source) )
+		writeFileAtomic( file.native(), source.data(), source.size() );
+	return file;
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+int run( const Jdk& jdk, const fs::path& warmUpDir, const fs::path& socketPath, int size )
+{
+	#ifdef _WIN32
+		THROW_M( L"JVM pool is not supported on Windows" );
+	#else
+		MUST_M( (jdk.version == 0) || (jdk.version >= 9), L"JVM pool requires JDK 9+" );
+		Expected<int> running = LocalSocket::connectTo( socketPath );
+		if( running )
+		{
+			close( *running );
+			THROW_M( L"JVM pool is already running: " + fromPath( socketPath ) );
+		}
+
+		int listenFd = LocalSocket::listenOn( socketPath, 128 );
+		fcntl( listenFd, F_SETFL, O_NONBLOCK );
+		int notify[ 2 ];
+		MUST_M( pipe( notify ) == 0, L"Can't create pipe" );
+		fcntl( notify[ 0 ], F_SETFD, FD_CLOEXEC );
+		fcntl( notify[ 1 ], F_SETFD, FD_CLOEXEC );
+		fcntl( notify[ 0 ], F_SETFL, O_NONBLOCK );
+
+		// Pool holds write end: idle workers see end of file, when pool stops or dies
+		int lifeline[ 2 ];
+		MUST_M( pipe( lifeline ) == 0, L"Can't create pipe" );
+		fcntl( lifeline[ 0 ], F_SETFD, FD_CLOEXEC );
+		fcntl( lifeline[ 1 ], F_SETFD, FD_CLOEXEC );
+
+		struct sigaction action = {};
+		action.sa_handler = onStopSignal;
+		sigaction( SIGINT, &action, nullptr );
+		sigaction( SIGTERM, &action, nullptr );
+
+		std::set<pid_t> idle;
+		auto spawn = [&]()
+		{
+			pid_t pid = fork();
+			MUST_M( pid != -1, L"Can't start worker of JVM pool" );
+			if( pid == 0 )
+			{
+				close( notify[ 0 ] );
+				close( lifeline[ 1 ] );
+				runWorker( jdk, warmUpDir, listenFd, notify[ 1 ], lifeline[ 0 ] );
+			}
+			idle.insert( pid );
+		};
+
+		wstring error;
+		int quickExits = 0;
+		try
+		{
+			for( int i = 0; i < size; ++i )
+				spawn();
+			LOGI( "JVM pool started: {} JVMs, socket {}", size, socketPath.string() );
+
+			while( !stopRequested )
+			{
+				pollfd p = { notify[ 0 ], POLLIN, 0 };
+				poll( &p, 1, 1000 );
+
+				// Workers, which have got programmes. Read all before reaping: worker writes its pid before exit.
+				int32_t pids[ 64 ];
+				ssize_t bytes;
+				while( (bytes = read( notify[ 0 ], pids, sizeof( pids ) )) > 0 )
+				{
+					for( ssize_t i = 0; i < bytes / (ssize_t)sizeof( int32_t ); ++i )
+					{
+						if( idle.erase( pids[ i ] ) != 0 )
+						{
+							quickExits = 0;
+							spawn();
+						}
+					}
+				}
+
+				// Idle worker, which has exited, could not start JVM
+				int status = 0;
+				pid_t pid;
+				while( (pid = waitpid( -1, &status, WNOHANG )) > 0 )
+				{
+					if( idle.erase( pid ) == 0 )
+						continue;
+					MUST_M( ++quickExits < 3, L"Workers of JVM pool exit right after start" );
+					LOGW( "Worker {} of JVM pool exited with status {}, restarting", (int)pid,
+						WIFEXITED( status ) ? WEXITSTATUS( status ) : 128 + WTERMSIG( status ) );
+					Denom::sleep( 1000 );
+					spawn();
+				}
+			}
+		}
+		catch( Denom::Exception& ex )
+		{
+			error = ex.message;
+		}
+
+		// Idle workers exit on end of lifeline; workers, which run programmes, finish them
+		close( listenFd );
+		close( notify[ 0 ] );
+		close( notify[ 1 ] );
+		close( lifeline[ 0 ] );
+		close( lifeline[ 1 ] );
+		std::error_code ec;
+		fs::remove( socketPath, ec );
+
+		MUST_M( error.empty(), error );
+		LOGI( "JVM pool stopped" );
+		return 0;
+	#endif
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+Expected<int> launch( const fs::path& socketPath, const fs::path& classesDir, const wstring& mainClass,
+	const vector<string>& args )
+{
+	#ifdef _WIN32
+		return Error{ ErrorCode::NotFound, "JVM pool is not supported on Windows", 0 };
+	#else
+		static Counter& pooled = Metrics::counter( "jvm.pooled" );
+		static Counter& refused = Metrics::counter( "jvm.poolRefused" );
+
+		Expected<int> fd = LocalSocket::connectTo( socketPath, HANDOFF_TIMEOUT_MS );
+		if( !fd )
+			return fd.error();
+
+		string request;
+		std::error_code ec;
+		LocalSocket::putU32( request, MAGIC );
+		LocalSocket::putString( request, fs::current_path( ec ).string() );
+		LocalSocket::putString( request, classesDir.string() );
+		LocalSocket::putString( request, w2s( mainClass ) );
+		LocalSocket::putU32( request, (uint32_t)args.size() );
+		for( const string& arg : args )
+			LocalSocket::putString( request, arg );
+		vector<string> env;
+		for( char** var = environ; var && *var; ++var )
+			env.push_back( *var );
+		LocalSocket::putU32( request, (uint32_t)env.size() );
+		for( const string& var : env )
+			LocalSocket::putString( request, var );
+
+		const int stdFds[ 3 ] = { 0, 1, 2 };
+		uint32_t pid = 0;
+		errno = 0;
+		bool ok = LocalSocket::sendAll( *fd, request.data(), request.size() ) &&
+			LocalSocket::sendFds( *fd, stdFds, 3 ) && LocalSocket::recvU32( *fd, pid );
+		if( ok && (pid == 0) )
+		{
+			close( *fd );
+			refused.add();
+			return Error{ ErrorCode::NotFound, "JVM pool can't run programme without static main(String[])", 0 };
+		}
+		ok = ok && sendU32( *fd, MAGIC );
+		if( !ok )
+		{
+			int err = errno;
+			close( *fd );
+			if( (err == EAGAIN) || (err == EWOULDBLOCK) )
+				return Error{ ErrorCode::IoError, "JVM pool does not respond", ETIMEDOUT };
+			return Error::fromErrno( "JVM pool closed connection", err );
+		}
+		pooled.add();
+		LocalSocket::setTimeout( *fd, 0 );
+
+		// Programme has started, now only its exit code is expected
+		workerPid = (pid_t)pid;
+		struct sigaction action = {};
+		struct sigaction previous[ 3 ];
+		const int signals[ 3 ] = { SIGINT, SIGTERM, SIGHUP };
+		action.sa_handler = forwardSignal;
+		for( int i = 0; i < 3; ++i )
+			sigaction( signals[ i ], &action, &previous[ i ] );
+
+		uint32_t code = 0;
+		ok = LocalSocket::recvU32( *fd, code );
+
+		for( int i = 0; i < 3; ++i )
+			sigaction( signals[ i ], &previous[ i ], nullptr );
+		workerPid = 0;
+		close( *fd );
+		MUST_M( ok, L"Worker of JVM pool has exited without exit code" );
+		return (int)code;
+	#endif
+}
+
+} // namespace JvmPool
@@ -0,0 +1,70 @@
+/// Denom.org
+///
+/// MIT No Attribution.
+///
+/// Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software
+/// without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+/// permit persons to whom the Software is furnished to do so.
+///
+/// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+/// PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+/// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+///
+/// Author:  Sergey Novochenko,  Digrol@gmail.com
+///
+/// Pool of started JVMs, which wait for programmes to run.
+
+#ifndef JVMPOOL_H_8D31E6A0B5F2C749
+#define JVMPOOL_H_8D31E6A0B5F2C749
+
+#include <string>
+#include <vector>
+#include <filesystem>
+#include "expected.h"
+#include "jdk.h"
+
+// ---------------------------------------------------------------------------------------------------------------------
+/// 'jrun --pool N' keeps N idle worker processes, each with embedded JVM (see EmbeddedJvm), which has started and
+/// run warm-up code. Workers wait on Unix domain socket; jrun connects to it and hands over the programme: classes
+/// directory, main class, arguments, environment, working directory and descriptors of stdin, stdout, stderr
+/// (SCM_RIGHTS). Worker runs the programme, sends its exit code back and exits; pool starts replacement worker
+/// right after handoff, not after exit, so pool stays full under bursty load. When pool stops, idle workers exit,
+/// and workers, which run programmes, finish them.
+/// Socket directory is accessible only by its owner, and workers serve only clients of the same user.
+///
+/// Programme in pool does not run exactly as by 'java', so jrun uses pool only if asked by '--use-pool':
+/// JVM options and environment variables, read by JVM at start (JAVA_TOOL_OPTIONS...), are taken from the pool -
+/// jrun runs 'java' itself, if they are set for launch. 'user.dir' is set to directory of launch, but java.io.File
+/// and java.nio.file resolve relative paths against directory of pool, if JDK caches it at start (JDK 11+).
+/// Programme is loaded by its own class loader: java.class.path is its classes directory, system class loader
+/// does not see them. Worker refuses programme without static main(String[]) (instance main of JDK 21+).
+/// Requires JDK 9+, not supported on Windows.
+///
+/// Protocol (numbers - 32-bit big-endian, strings - length and UTF-8 bytes; arguments - bytes of command line as is):
+///     request:  magic, cwd, classes directory, main class, count, count * argument, count, count * "NAME=value";
+///               then 1 byte with descriptors 0, 1, 2;
+///     response: pid of worker; 0 - worker can't run programme, client runs it by 'java';
+///     confirm:  magic - worker runs programme only after it, client which has timed out runs programme itself;
+///     response: exit code, when programme ends.
+namespace JvmPool
+{
+	/// Socket of pool for 'jdk': <cacheRoot>/pool/jvm-<hash of JDK identity>.sock
+	std::filesystem::path socketPath( const std::filesystem::path& cacheRoot, const Jdk& jdk );
+
+	/// Writes Java source of warm-up code to <cacheRoot>/pool/ (only if it differs).
+	/// @return path of source file.
+	std::filesystem::path writeWarmUpSource( const std::filesystem::path& cacheRoot );
+
+	/// Runs pool of 'size' workers, warm-up classes are in 'warmUpDir'.
+	/// Returns on SIGINT / SIGTERM; throws if workers exit right after start.
+	int run( const Jdk& jdk, const std::filesystem::path& warmUpDir, const std::filesystem::path& socketPath,
+		int size );
+
+	/// Run programme by worker of pool, signals SIGINT, SIGTERM, SIGHUP are forwarded to it.
+	/// @return exit code of programme; error if pool is not running, can't run programme or does not start it
+	/// within 5 seconds - caller should run programme itself.
+	Denom::Expected<int> launch( const std::filesystem::path& socketPath, const std::filesystem::path& classesDir,
+		const std::wstring& mainClass, const std::vector<std::string>& args );
+}
+
+#endif // Header guard
@@ -0,0 +1,295 @@
+/// Denom.org
+///
+/// MIT No Attribution.
+///
+/// Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software
+/// without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+/// permit persons to whom the Software is furnished to do so.
+///
+/// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+/// PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+/// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+///
+/// Author:  Sergey Novochenko,  Digrol@gmail.com
+///
+/// Unix domain sockets: connection and framing of messages between jrun processes and servers.
+
+#ifndef _WIN32
+
+#include <string>
+#include <algorithm>
+#include <cstring>
+#include <cerrno>
+#include "utils.h"
+#include "exception.h"
+#include "localsocket.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/time.h>
+
+namespace fs = std::filesystem;
+using std::string;
+using namespace Denom;
+
+namespace {
+
+#ifdef MSG_NOSIGNAL
+	const int SEND_FLAGS = MSG_NOSIGNAL; // other side can die - don't get SIGPIPE
+#else
+	const int SEND_FLAGS = 0;
+#endif
+
+// ---------------------------------------------------------------------------------------------------------------------
+/// @return false if path does not fit into sockaddr_un.
+bool makeAddress( const fs::path& path, sockaddr_un& addr )
+{
+	addr = {};
+	addr.sun_family = AF_UNIX;
+	const string& name = path.native();
+	if( name.size() >= sizeof( addr.sun_path ) )
+		return false;
+	memcpy( addr.sun_path, name.c_str(), name.size() + 1 );
+	return true;
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+int createSocket()
+{
+	int fd = socket( AF_UNIX, SOCK_STREAM, 0 );
+	if( fd == -1 )
+		return -1;
+	fcntl( fd, F_SETFD, FD_CLOEXEC );
+	#ifdef SO_NOSIGPIPE
+		int on = 1;
+		setsockopt( fd, SOL_SOCKET, SO_NOSIGPIPE, &on, sizeof( on ) );
+	#endif
+	return fd;
+}
+
+} // namespace
+
+namespace LocalSocket {
+
+// ---------------------------------------------------------------------------------------------------------------------
+void putU32( string& buf, uint32_t v )
+{
+	buf += (char)(v >> 24);
+	buf += (char)(v >> 16);
+	buf += (char)(v >> 8);
+	buf += (char)v;
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+void putString( string& buf, const string& s )
+{
+	putU32( buf, (uint32_t)s.size() );
+	buf += s;
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+bool sendAll( int fd, const char* p, size_t size )
+{
+	while( size != 0 )
+	{
+		ssize_t sent = send( fd, p, size, SEND_FLAGS );
+		if( sent < 0 )
+		{
+			if( errno == EINTR )
+				continue;
+			return false;
+		}
+		p += sent;
+		size -= (size_t)sent;
+	}
+	return true;
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+bool recvAll( int fd, char* p, size_t size )
+{
+	while( size != 0 )
+	{
+		ssize_t received = recv( fd, p, size, 0 );
+		if( received < 0 )
+		{
+			if( errno == EINTR )
+				continue;
+			return false;
+		}
+		if( received == 0 )
+			return false;
+		p += received;
+		size -= (size_t)received;
+	}
+	return true;
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+bool recvU32( int fd, uint32_t& v )
+{
+	uint8_t b[ 4 ];
+	if( !recvAll( fd, (char*)b, 4 ) )
+		return false;
+	v = ((uint32_t)b[ 0 ] << 24) | ((uint32_t)b[ 1 ] << 16) | ((uint32_t)b[ 2 ] << 8) | b[ 3 ];
+	return true;
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+bool recvString( int fd, string& s, uint32_t maxSize )
+{
+	uint32_t size = 0;
+	if( !recvU32( fd, size ) || (size > maxSize) )
+		return false;
+	s.resize( size );
+	return (size == 0) || recvAll( fd, &s[ 0 ], size );
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+bool sendFds( int fd, const int* fds, int count )
+{
+	char byte = 0;
+	iovec iov = { &byte, 1 };
+	string control( CMSG_SPACE( sizeof( int ) * count ), '\0' );
+
+	msghdr msg = {};
+	msg.msg_iov = &iov;
+	msg.msg_iovlen = 1;
+	msg.msg_control = &control[ 0 ];
+	msg.msg_controllen = control.size();
+
+	cmsghdr* cmsg = CMSG_FIRSTHDR( &msg );
+	cmsg->cmsg_level = SOL_SOCKET;
+	cmsg->cmsg_type = SCM_RIGHTS;
+	cmsg->cmsg_len = CMSG_LEN( sizeof( int ) * count );
+	memcpy( CMSG_DATA( cmsg ), fds, sizeof( int ) * count );
+
+	ssize_t sent;
+	while( ((sent = sendmsg( fd, &msg, SEND_FLAGS )) == -1) && (errno == EINTR) )
+	{
+	}
+	return sent == 1;
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+bool recvFds( int fd, int* fds, int count )
+{
+	char byte = 0;
+	iovec iov = { &byte, 1 };
+	string control( CMSG_SPACE( sizeof( int ) * count ), '\0' );
+
+	msghdr msg = {};
+	msg.msg_iov = &iov;
+	msg.msg_iovlen = 1;
+	msg.msg_control = &control[ 0 ];
+	msg.msg_controllen = control.size();
+
+	#ifdef MSG_CMSG_CLOEXEC
+		const int flags = MSG_CMSG_CLOEXEC;
+	#else
+		const int flags = 0;
+	#endif
+	ssize_t received;
+	while( ((received = recvmsg( fd, &msg, flags )) == -1) && (errno == EINTR) )
+	{
+	}
+
+	cmsghdr* cmsg = CMSG_FIRSTHDR( &msg );
+	if( (received != 1) || !cmsg || (cmsg->cmsg_type != SCM_RIGHTS) )
+		return false;
+
+	int receivedCount = (int)((cmsg->cmsg_len - CMSG_LEN( 0 )) / sizeof( int ));
+	memcpy( fds, CMSG_DATA( cmsg ), sizeof( int ) * std::min( count, receivedCount ) );
+	if( receivedCount != count )
+	{
+		for( int i = 0; i < std::min( count, receivedCount ); ++i )
+			close( fds[ i ] );
+		return false;
+	}
+	for( int i = 0; i < count; ++i )
+		fcntl( fds[ i ], F_SETFD, FD_CLOEXEC );
+	return true;
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+void setTimeout( int fd, int timeoutMs )
+{
+	timeval tv = {};
+	tv.tv_sec = timeoutMs / 1000;
+	tv.tv_usec = (timeoutMs % 1000) * 1000;
+	setsockopt( fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof( tv ) );
+	setsockopt( fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof( tv ) );
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+Expected<int> connectTo( const fs::path& path, int timeoutMs )
+{
+	sockaddr_un addr;
+	if( !makeAddress( path, addr ) )
+		return Error{ ErrorCode::NotFound, "Socket path is too long", 0 };
+
+	int fd = createSocket();
+	if( fd == -1 )
+		return Error::fromErrno( "Can't create socket", errno );
+	if( timeoutMs != 0 )
+		setTimeout( fd, timeoutMs ); // connect waits while backlog of server is full
+
+	if( connect( fd, (const sockaddr*)&addr, sizeof( addr ) ) != 0 )
+	{
+		Error err = Error::fromErrno( "Can't connect to socket", errno );
+		close( fd );
+		return err;
+	}
+	return fd;
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+void createPrivateDirectory( const fs::path& dir )
+{
+	std::error_code ec;
+	fs::create_directories( dir, ec );
+	MUST_M( !ec, L"Can't create directory: " + fromPath( dir ) );
+	fs::permissions( dir, fs::perms::owner_all, fs::perm_options::replace, ec );
+	MUST_M( !ec, L"Can't set permissions of directory: " + fromPath( dir ) );
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+int listenOn( const fs::path& path, int backlog )
+{
+	sockaddr_un addr;
+	MUST_M( makeAddress( path, addr ), L"Socket path is too long: " + fromPath( path ) );
+
+	createPrivateDirectory( path.parent_path() );
+	std::error_code ec;
+	fs::remove( path, ec );
+
+	int fd = createSocket();
+	MUST_M( fd != -1, L"Can't create socket" );
+	if( (bind( fd, (const sockaddr*)&addr, sizeof( addr ) ) != 0) || (listen( fd, backlog ) != 0) )
+	{
+		int err = errno;
+		close( fd );
+		THROW_M( L"Can't listen on " + fromPath( path ) + L": " + s2w( strerror( err ) ) );
+	}
+	return fd;
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+bool isPeerOwner( int fd )
+{
+	#ifdef SO_PEERCRED
+		ucred cred = {};
+		socklen_t size = sizeof( cred );
+		return (getsockopt( fd, SOL_SOCKET, SO_PEERCRED, &cred, &size ) == 0) && (cred.uid == geteuid());
+	#else
+		uid_t uid = 0;
+		gid_t gid = 0;
+		return (getpeereid( fd, &uid, &gid ) == 0) && (uid == geteuid());
+	#endif
+}
+
+} // namespace LocalSocket
+
+#endif // !_WIN32
@@ -0,0 +1,69 @@
+/// Denom.org
+///
+/// MIT No Attribution.
+///
+/// Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software
+/// without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+/// permit persons to whom the Software is furnished to do so.
+///
+/// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+/// PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+/// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+///
+/// Author:  Sergey Novochenko,  Digrol@gmail.com
+///
+/// Unix domain sockets: connection and framing of messages between jrun processes and servers.
+
+#ifndef LOCALSOCKET_H_0F7D2B96A4E1C385
+#define LOCALSOCKET_H_0F7D2B96A4E1C385
+
+#ifndef _WIN32
+
+#include <stdint.h>
+#include <string>
+#include <filesystem>
+#include "expected.h"
+
+// ---------------------------------------------------------------------------------------------------------------------
+/// Stream sockets with path in file system. Numbers are 32-bit big-endian, strings - length and UTF-8 bytes.
+/// Functions return false if connection is closed or broken; SIGPIPE is not raised.
+namespace LocalSocket
+{
+	void putU32( std::string& buf, uint32_t v );
+	void putString( std::string& buf, const std::string& s );
+
+	bool sendAll( int fd, const char* p, size_t size );
+	bool recvAll( int fd, char* p, size_t size );
+	bool recvU32( int fd, uint32_t& v );
+
+	/// @param maxSize - protection from garbage in length.
+	bool recvString( int fd, std::string& s, uint32_t maxSize = 1 << 20 );
+
+	/// Pass open file descriptors to process on the other side (SCM_RIGHTS) with one byte of data.
+	bool sendFds( int fd, const int* fds, int count );
+
+	/// Receive exactly 'count' descriptors, sent by 'sendFds'. They are close-on-exec.
+	bool recvFds( int fd, int* fds, int count );
+
+	/// Limit of time of each send and receive on 'fd'; after it they fail with EAGAIN. 0 - no limit.
+	void setTimeout( int fd, int timeoutMs );
+
+	/// @param timeoutMs - limit of connect and of each send and receive on the socket, see 'setTimeout'.
+	/// @return connected socket, close-on-exec.
+	Denom::Expected<int> connectTo( const std::filesystem::path& path, int timeoutMs = 0 );
+
+	/// Creates directory for sockets, accessible only by its owner (0700): socket files are created with umask,
+	/// so permissions of directory protect them. Throws Denom::Exception on error.
+	void createPrivateDirectory( const std::filesystem::path& dir );
+
+	/// Creates listening socket on 'path', replacing stale socket file. Parent directory is made private.
+	/// Throws Denom::Exception on error.
+	int listenOn( const std::filesystem::path& path, int backlog );
+
+	/// @return true if process on the other side of connected socket runs as the same user as this process.
+	bool isPeerOwner( int fd );
+}
+
+#endif // !_WIN32
+
+#endif // Header guard
@@ -18,20 +18,31 @@
 
 #include "exception.h"
 #include "binary.h"
+#include "binaryspan.h"
 #include "utils.h"
+#include "random.h"
+#include "metrics.h"
+#include "trace.h"
+#include "files.h"
+#include "hex.h"
+#include "cpu.h"
 #include <sys/stat.h>
+#include <fcntl.h>
+#include <cerrno>
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+#ifdef DENOM_X86
+#include <immintrin.h>
+#endif
 
 using std::wstring;
 
 namespace {
 
-// ---------------------------------------------------------------------------------------------------------------------
-/// Convert lower nibble to char or wchar
-char nibbleChars[16] = { '0', '1', '2', '3', '4', '5', '6', '7', '8', '9', 'A', 'B', 'C', 'D', 'E', 'F' };
-char nibblechars[16] = { '0', '1', '2', '3', '4', '5', '6', '7', '8', '9', 'a', 'b', 'c', 'd', 'e', 'f' };
-wchar_t nibbleWChars[ 16 ] = { L'0', L'1', L'2', L'3', L'4', L'5', L'6', L'7', L'8', L'9', L'A', L'B', L'C', L'D', L'E', L'F' };
-wchar_t nibblewchars[ 16 ] = { L'0', L'1', L'2', L'3', L'4', L'5', L'6', L'7', L'8', L'9', L'a', L'b', L'c', L'd', L'e', L'f' };
-
 // ---------------------------------------------------------------------------------------------------------------------
 /// Converts HEX character into an appropriate number.
 /// @param hexSymbol - '0'..'9', 'A'..'F', 'a'..'f', codes of these characters in ASCII.
@@ -72,6 +83,85 @@ uint8_t wchar2nibble( wchar_t ch )
 	return 0xFF;
 }
 
+// ---------------------------------------------------------------------------------------------------------------------
+/// Bitwise operations for 'applyOp'.
+struct OpXor
+{
+	static uint64_t apply( uint64_t a, uint64_t b ) { return a ^ b; }
+	#ifdef DENOM_X86
+		DENOM_TARGET( "avx2" ) static __m256i apply( __m256i a, __m256i b ) { return _mm256_xor_si256( a, b ); }
+	#endif
+};
+
+struct OpOr
+{
+	static uint64_t apply( uint64_t a, uint64_t b ) { return a | b; }
+	#ifdef DENOM_X86
+		DENOM_TARGET( "avx2" ) static __m256i apply( __m256i a, __m256i b ) { return _mm256_or_si256( a, b ); }
+	#endif
+};
+
+struct OpAnd
+{
+	static uint64_t apply( uint64_t a, uint64_t b ) { return a & b; }
+	#ifdef DENOM_X86
+		DENOM_TARGET( "avx2" ) static __m256i apply( __m256i a, __m256i b ) { return _mm256_and_si256( a, b ); }
+	#endif
+};
+
+#ifdef DENOM_X86
+// ---------------------------------------------------------------------------------------------------------------------
+/// 128 bytes per step. Returns number of processed bytes.
+template< typename Op >
+DENOM_TARGET( "avx2" ) size_t applyOpAvx2( uint8_t* dst, const uint8_t* a, const uint8_t* b, size_t len )
+{
+	size_t i = 0;
+	for( ; i + 128 <= len; i += 128 )
+	{
+		__m256i r0 = Op::apply( _mm256_loadu_si256( (const __m256i*)(a + i) ),      _mm256_loadu_si256( (const __m256i*)(b + i) ) );
+		__m256i r1 = Op::apply( _mm256_loadu_si256( (const __m256i*)(a + i + 32) ), _mm256_loadu_si256( (const __m256i*)(b + i + 32) ) );
+		__m256i r2 = Op::apply( _mm256_loadu_si256( (const __m256i*)(a + i + 64) ), _mm256_loadu_si256( (const __m256i*)(b + i + 64) ) );
+		__m256i r3 = Op::apply( _mm256_loadu_si256( (const __m256i*)(a + i + 96) ), _mm256_loadu_si256( (const __m256i*)(b + i + 96) ) );
+		_mm256_storeu_si256( (__m256i*)(dst + i), r0 );
+		_mm256_storeu_si256( (__m256i*)(dst + i + 32), r1 );
+		_mm256_storeu_si256( (__m256i*)(dst + i + 64), r2 );
+		_mm256_storeu_si256( (__m256i*)(dst + i + 96), r3 );
+	}
+	for( ; i + 32 <= len; i += 32 )
+	{
+		__m256i r = Op::apply( _mm256_loadu_si256( (const __m256i*)(a + i) ), _mm256_loadu_si256( (const __m256i*)(b + i) ) );
+		_mm256_storeu_si256( (__m256i*)(dst + i), r );
+	}
+	return i;
+}
+#endif
+
+// ---------------------------------------------------------------------------------------------------------------------
+/// dst[i] = Op( a[i], b[i] ). With AVX2 - by 32 bytes, otherwise by 8-byte words.
+template< typename Op >
+void applyOp( uint8_t* dst, const uint8_t* a, const uint8_t* b, size_t len )
+{
+	size_t i = 0;
+
+	#ifdef DENOM_X86
+		if( Denom::cpuFeatures().avx2 )
+			i = applyOpAvx2<Op>( dst, a, b, len );
+	#endif
+
+	for( ; i + 8 <= len; i += 8 )
+	{
+		uint64_t wa, wb;
+		memcpy( &wa, a + i, 8 );
+		memcpy( &wb, b + i, 8 );
+		wa = Op::apply( wa, wb );
+		memcpy( dst + i, &wa, 8 );
+	}
+	for( ; i < len; ++i )
+	{
+		dst[ i ] = (uint8_t)Op::apply( a[ i ], b[ i ] );
+	}
+}
+
 } // namespace
 
 
@@ -82,7 +172,17 @@ Binary::Binary( const char* hex )
 {
 	MUST_M( hex != NULL, L"NULL Ptr" );
 
-	reserve( strlen(hex) >> 1 );
+	// Fast path: string without separators
+	size_t len = strlen( hex );
+	if( !(len & 1) )
+	{
+		resize( len >> 1 );
+		if( hexDecode( hex, len, data() ) )
+			return;
+		clear();
+	}
+
+	reserve( len >> 1 );
 	uint8_t nibble = 0;     // current nibble
 	uint8_t highNibble = 0;
 	bool flag = false;      // Set if got 1 nibble
@@ -163,226 +263,168 @@ Binary& Binary::operator+=( uint8_t byte )
 // ---------------------------------------------------------------------------------------------------------------------
 wstring Binary::Hex( uint32_t oneSpace, uint32_t twoSpaces, uint32_t newLine, uint32_t lineShift ) const
 {
-	if( empty() )
-	{
-		return wstring();
-	}
-
-	wstring res;
-	res.reserve( size() * (2 + (oneSpace ? 1 : 0)) );
-
-	wstring shiftStr( lineShift, L' ' );
-	res += shiftStr;
-	uint8_t byte = at( 0 );
-	res += nibbleWChars[ byte >> 4 ];
-	res += nibbleWChars[ byte & 0x0F ];
-
-	for( size_type i = 1; i < size(); ++i )
-	{
-		if( newLine && !(i % newLine) )
-		{
-			res += L'\n';
-			res += shiftStr;
-		}
-		else if( twoSpaces && !(i % twoSpaces) )
-		{
-			res += L"  ";
-		}
-		else if( oneSpace && !(i % oneSpace) )
-		{
-			res += L" ";
-		}
-		byte = at( i );
-		res += nibbleWChars[ byte >> 4 ];
-		res += nibbleWChars[ byte & 0x0F ];
-	}
-	return res;
+	return BinarySpan( *this ).Hex( oneSpace, twoSpaces, newLine, lineShift );
 }
 
 // ---------------------------------------------------------------------------------------------------------------------
 wstring Binary::hex( uint32_t oneSpace, uint32_t twoSpaces, uint32_t newLine, uint32_t lineShift ) const
 {
-	if( empty() )
-	{
-		return wstring();
-	}
-
-	wstring res;
-	res.reserve( size() * 3 );
+	return BinarySpan( *this ).hex( oneSpace, twoSpaces, newLine, lineShift );
+}
 
-	wstring shiftStr( lineShift, L' ' );
-	res += shiftStr;
-	uint8_t byte = at( 0 );
-	res += nibblewchars[ byte >> 4 ];
-	res += nibblewchars[ byte & 0x0F ];
+// ---------------------------------------------------------------------------------------------------------------------
+std::string Binary::HexStr( uint32_t oneSpace, uint32_t twoSpaces, uint32_t newLine, uint32_t lineShift ) const
+{
+	return BinarySpan( *this ).HexStr( oneSpace, twoSpaces, newLine, lineShift );
+}
 
-	for( size_type i = 1; i < size(); ++i )
-	{
-		if( newLine && !(i % newLine) )
-		{
-			res += L'\n';
-			res += shiftStr;
-		}
-		else if( twoSpaces && !(i % twoSpaces) )
-		{
-			res += L"  ";
-		}
-		else if( oneSpace && !(i % oneSpace) )
-		{
-			res += L" ";
-		}
-		byte = at( i );
-		res += nibblewchars[ byte >> 4 ];
-		res += nibblewchars[ byte & 0x0F ];
-	}
-	return res;
+// ---------------------------------------------------------------------------------------------------------------------
+std::string Binary::hexStr( uint32_t oneSpace, uint32_t twoSpaces, uint32_t newLine, uint32_t lineShift ) const
+{
+	return BinarySpan( *this ).hexStr( oneSpace, twoSpaces, newLine, lineShift );
 }
 
-static uint64_t getFileSize( const wstring& filename )
+// ---------------------------------------------------------------------------------------------------------------------
+static void closeFile( int fd )
 {
-	#ifdef _WIN32
-		struct __stat64 fileStat;
-		MUST_M( _wstat64( filename.c_str(), &fileStat ) == 0, L"Can't get file size: " + filename );
-		return static_cast<uint64_t>(fileStat.st_size);
+	#ifdef _WIN32
+		_close( fd );
 	#else
-		struct stat fileStat;
-		MUST_M( stat( w2s(filename).c_str(), &fileStat ) == 0, L"Can't get file size: " + filename );
-		return static_cast<uint64_t>(fileStat.st_size);
+		close( fd );
 	#endif
 }
 
 // ---------------------------------------------------------------------------------------------------------------------
-Binary& Binary::loadFromFile( const wstring& filename )
+static Expected<size_t> loadNative( Binary& bin, const NativeName& filename )
 {
-	clear();
-
-	uint64_t fileSize = getFileSize( filename );
-	if (fileSize == 0) return *this;
-
+	TraceSpan span( "Binary::loadFromFile" );
+	bin.clear();
 
-	#ifdef _WIN32
-		FILE* f = _wfopen( filename.c_str(), L"rb" );
+	#ifdef _WIN32
+		int fd = _wopen( filename.c_str(), _O_RDONLY | _O_BINARY );
 	#else
-		FILE* f = fopen( w2s( filename ).c_str(), "rb" );
-	#endif // _WIN32
-	MUST_M( f != NULL, L"Can't open file: " + filename );
+		int fd = open( filename.c_str(), O_RDONLY | O_CLOEXEC );
+	#endif // _WIN32
+	if( fd == -1 )
+		return Error::fromErrno( "Can't open file", errno );
 
-	resize( fileSize );
-	uint8_t* p = &(*this)[ 0 ];
+	#ifdef _WIN32
+		struct __stat64 fileStat;
+		bool statOk = _fstat64( fd, &fileStat ) == 0;
+	#else
+		struct stat fileStat;
+		bool statOk = fstat( fd, &fileStat ) == 0;
+	#endif
+	if( !statOk )
+	{
+		Error err = Error::fromErrno( "Can't get file size", errno );
+		closeFile( fd );
+		return err;
+	}
 
-	uint8_t buf[ 60000 ];
-	size_t bytes_read = fread( buf, 1, 60000, f );
-	size_t sz = bytes_read;
-	while( bytes_read != 0 )
+	// Read directly into array, without intermediate buffer
+	bin.resize( (size_t)fileStat.st_size );
+	size_t total = 0;
+	while( total < bin.size() )
 	{
-		MUST( sz <= size() );
-		std::copy( buf, buf + bytes_read, p );
-		p += bytes_read;
-		bytes_read = fread( buf, 1, 60000, f );
-		sz += bytes_read;
+		size_t chunk = std::min( bin.size() - total, (size_t)(1 << 30) );
+		#ifdef _WIN32
+			int bytesRead = _read( fd, bin.data() + total, (unsigned int)chunk );
+		#else
+			ssize_t bytesRead = read( fd, bin.data() + total, chunk );
+			if( (bytesRead < 0) && (errno == EINTR) )
+				continue;
+		#endif
+		if( bytesRead < 0 )
+		{
+			Error err = Error::fromErrno( "Can't read file", errno );
+			closeFile( fd );
+			bin.clear();
+			return err;
+		}
+		if( bytesRead == 0 )
+			break;
+		total += (size_t)bytesRead;
 	}
-	fclose( f );
+	closeFile( fd );
 
-	return *this;
+	static Counter& bytesRead = Metrics::counter( "file.bytesRead" );
+	bytesRead.add( total );
+
+	// File could be truncated while reading
+	bin.resize( total );
+	return total;
 }
 
 // ---------------------------------------------------------------------------------------------------------------------
-void Binary::saveToFile( const std::wstring& filename )
+static void loadOrThrow( Binary& bin, const NativeName& filename )
 {
-	#ifdef _WIN32
-		FILE* f = _wfopen( filename.c_str(), L"wb" );
-	#else
-		FILE* f = fopen( w2s(filename).c_str(), "wb" );
-	#endif // _WIN32
-	MUST_M( f != NULL, L"Can't open file: " + filename );
+	Expected<size_t> loaded = loadNative( bin, filename );
+	if( !loaded )
+		loaded.error().raise( fromNative( filename ) );
+}
 
-	size_t written = 0;
-	if( !empty() )
-	{
-		written = fwrite( &(*this)[ 0 ], 1, size(), f );
-	}
-	fflush( f );
-	fclose( f );
+// ---------------------------------------------------------------------------------------------------------------------
+Binary& Binary::loadFromFile( const wstring& filename )
+{
+	loadOrThrow( *this, toNative( filename ) );
+	return *this;
+}
 
-	MUST_M( written == size(), L"Can't write all data from Binary to file" );
+// ---------------------------------------------------------------------------------------------------------------------
+Binary& Binary::loadFromFile( std::string_view filename )
+{
+	loadOrThrow( *this, toNative( filename ) );
+	return *this;
 }
 
 // ---------------------------------------------------------------------------------------------------------------------
-uint16_t Binary::U16() const
+Expected<size_t> Binary::tryLoadFromFile( const wstring& filename )
 {
-	switch( size() )
-	{
-	case 0:
-		return 0;
-	case 1:
-		return (*this)[0];
-	case 2:
-		return ((uint16_t)((*this)[0]) << 8) | (*this)[1];
-	default:
-		THROW_M( L"Size of Binary can't be more than 2 bytes to interpret it as U16" );
-	}
-	return 0;
+	return loadNative( *this, toNative( filename ) );
 }
 
 // ---------------------------------------------------------------------------------------------------------------------
-uint32_t Binary::U32() const
+Expected<size_t> Binary::tryLoadFromFile( std::string_view filename )
 {
-	if( empty() )
-	{
-		return 0;
-	}
+	return loadNative( *this, toNative( filename ) );
+}
 
-	uint32_t num = 0;
-	size_t len = size();
+// ---------------------------------------------------------------------------------------------------------------------
+void Binary::saveToFile( const std::wstring& filename )
+{
+	writeFile( filename, data(), size() );
+}
 
-	MUST_M( sizeof(num) >= size(), L"Size of Binary can't be more than 4 bytes to interpret it as U32" );
+// ---------------------------------------------------------------------------------------------------------------------
+void Binary::saveToFile( std::string_view filename )
+{
+	writeFile( filename, data(), size() );
+}
 
-	uint8_t* p = (uint8_t*)&num;
-	do 
-	{
-		--len;
-		*p = (*this)[ len ];
-		++p;
-	}
-	while( len != 0 );
+// ---------------------------------------------------------------------------------------------------------------------
+uint16_t Binary::U16() const
+{
+	return BinarySpan( *this ).U16();
+}
 
-	return num;
+// ---------------------------------------------------------------------------------------------------------------------
+uint32_t Binary::U32() const
+{
+	return BinarySpan( *this ).U32();
 }
 
-// -----------------------------------------------------------------------------
+// ---------------------------------------------------------------------------------------------------------------------
 uint64_t Binary::U64() const
 {
-	if( empty() )
-	{
-		return 0;
-	}
-
-	uint64_t num = 0;
-	size_t len = size();
-
-	MUST_M( sizeof(num) >= len, L"Size of Binary can't be more than 8 bytes to interpret it as U64" );
-
-	uint8_t* p = (uint8_t*)&num;
-	do 
-	{
-		--len;
-		*p = (*this)[ len ];
-		++p;
-	}
-	while( len != 0 );
-
-	return num;
+	return BinarySpan( *this ).U64();
 }
 
 // -----------------------------------------------------------------------------
 Binary& Binary::random( size_type size )
 {
-	clear();
-	reserve( size );
-	for( unsigned i = 0; i < size; ++i )
-	{
-		push_back( (uint8_t)RangedRand( 0, 255 ) );
-	}
+	resize( size );
+	Random::local().fill( data(), size );
 	return *this;
 }
 
@@ -511,48 +553,63 @@ Binary operator+( uint8_t byte, const Binary& binary )
 }
 
 // ---------------------------------------------------------------------------------------------------------------------
-Binary operator^( const Binary& left, const Binary& right )
+void xorInto( uint8_t* dst, const uint8_t* a, const uint8_t* b, size_t len )
 {
-	size_t sz = left.size();
-	MUST_M( sz == right.size(), L"Size of Binary arrays must be equal in operator '^'" );
+	applyOp<OpXor>( dst, a, b, len );
+}
 
-	Binary result;
-	result.reserve(sz);
-	for( size_t i = 0; i < sz; ++i )
-	{
-		result.push_back( left[i] ^ right[i] );
-	}
-	return result;
+// ---------------------------------------------------------------------------------------------------------------------
+void orInto( uint8_t* dst, const uint8_t* a, const uint8_t* b, size_t len )
+{
+	applyOp<OpOr>( dst, a, b, len );
 }
 
 // ---------------------------------------------------------------------------------------------------------------------
-Binary operator|( const Binary& left, const Binary& right )
+void andInto( uint8_t* dst, const uint8_t* a, const uint8_t* b, size_t len )
 {
-	size_t sz = left.size();
-	MUST_M( left.size() == right.size(), L"Size of Binary arrays must be equal in operator '|'" );
+	applyOp<OpAnd>( dst, a, b, len );
+}
 
-	Binary result;
-	result.reserve(sz);
-	for( unsigned i = 0; i < sz; ++i )
-	{
-		result.push_back( left[i] | right[i] );
-	}
-	return result;
+// ---------------------------------------------------------------------------------------------------------------------
+Binary& Binary::operator^=( const Binary& right )
+{
+	MUST_M( size() == right.size(), L"Size of Binary arrays must be equal in operator '^'" );
+	xorInto( data(), data(), right.data(), size() );
+	return *this;
 }
 
 // ---------------------------------------------------------------------------------------------------------------------
-Binary operator&(const Binary& left, const Binary& right)
+Binary& Binary::operator|=( const Binary& right )
 {
-	size_t sz = left.size();
-	MUST_M( left.size() == right.size(), L"Size of Binary arrays must be equal in operator '&'" );
+	MUST_M( size() == right.size(), L"Size of Binary arrays must be equal in operator '|'" );
+	orInto( data(), data(), right.data(), size() );
+	return *this;
+}
 
-	Binary result;
-	result.reserve(sz);
-	for( unsigned i = 0; i < sz; ++i )
-	{
-		result.push_back(left[i] & right[i]);
-	}
-	return result;
+// ---------------------------------------------------------------------------------------------------------------------
+Binary& Binary::operator&=( const Binary& right )
+{
+	MUST_M( size() == right.size(), L"Size of Binary arrays must be equal in operator '&'" );
+	andInto( data(), data(), right.data(), size() );
+	return *this;
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+Binary operator^( const Binary& left, const Binary& right )
+{
+	return Binary( left ) ^= right;
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+Binary operator|( const Binary& left, const Binary& right )
+{
+	return Binary( left ) |= right;
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+Binary operator&( const Binary& left, const Binary& right )
+{
+	return Binary( left ) &= right;
 }
 
 } // namespace Denom
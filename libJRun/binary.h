@@ -22,6 +22,8 @@
 #include <stdint.h>
 #include <vector>
 #include <string>
+#include <string_view>
+#include "expected.h"
 
 namespace Denom {
 
@@ -62,6 +64,12 @@ public:
 	/// Append Byte to the end of array
 	Binary& operator+=( uint8_t byte );
 
+	// ---------------------------------------------------------------------------------------------------------------------
+	/// Bitwise operations in place, without allocation. Arrays should be same size.
+	Binary& operator^=( const Binary& right );
+	Binary& operator|=( const Binary& right );
+	Binary& operator&=( const Binary& right );
+
 	// ---------------------------------------------------------------------------------------------------------------------
 	/// Convert array to HEX-string in formatted form for printing.
 	/// All letters are capitalized.
@@ -73,6 +81,10 @@ public:
 	/// All letters are lowercase
 	std::wstring hex( uint32_t oneSpace = 0, uint32_t twoSpaces = 0, uint32_t newLine = 0, uint32_t lineShift = 0 ) const;
 
+	/// The same, but in narrow string (ASCII).
+	std::string HexStr( uint32_t oneSpace = 0, uint32_t twoSpaces = 0, uint32_t newLine = 0, uint32_t lineShift = 0 ) const;
+	std::string hexStr( uint32_t oneSpace = 0, uint32_t twoSpaces = 0, uint32_t newLine = 0, uint32_t lineShift = 0 ) const;
+
 	// ---------------------------------------------------------------------------------------------------------------------
 	/// Interpret array as unsigned integer.
 	/// First byte is highest (BigEndian).
@@ -87,6 +99,7 @@ public:
 	// ---------------------------------------------------------------------------------------------------------------------
 	/// Make a slice from array, like 'substr' for 'string'.
 	/// Checking for array out of bounds.
+	/// Bytes are copied, use BinarySpan( bin ).slice() to parse without copying.
 	/// @param offset - fragment starts at this offset.
 	/// @param count - number of bytes in fragment.
 	Binary slice( size_type offset, size_type count ) const;
@@ -100,7 +113,7 @@ public:
 	Binary last( size_type count ) const;
 
 	// ---------------------------------------------------------------------------------------------------------------------
-	/// Fill array with random data.
+	/// Fill array with pseudo random data, see 'Random'. Not for keys - use 'secureRandomFill'.
 	/// @param size - desired size of array.
 	/// @return - this.
 	Binary& random( size_type size );
@@ -123,11 +136,19 @@ public:
 
 	// -----------------------------------------------------------------------------------------------------------------
 	/// Load file as byte array.
+	/// @param filename - std::wstring or UTF-8, which is passed to OS as is on Linux, see 'NativeName'.
 	/// @return - this.
 	Binary& loadFromFile( const std::wstring& filename );
+	Binary& loadFromFile( std::string_view filename );
 
-	/// Save this array to file.
+	/// Non-throwing variants, for files which may be absent. On error array is empty.
+	/// @return - number of loaded bytes or error.
+	Expected<size_t> tryLoadFromFile( const std::wstring& filename );
+	Expected<size_t> tryLoadFromFile( std::string_view filename );
+
+	/// Save this array to file in place, see 'writeFile'.
 	void saveToFile( const std::wstring& filename );
+	void saveToFile( std::string_view filename );
 
 	// -----------------------------------------------------------------------------------------------------------------
 	/// Increment by 1. Interpret array as BigEndian unsigned number.
@@ -164,6 +185,13 @@ Binary operator|( const Binary& left, const Binary& right );
 /// AND two binary arrays (should be same size)
 Binary operator&( const Binary& left, const Binary& right );
 
+// -----------------------------------------------------------------------------------------------------------------
+/// Bitwise operations on byte ranges: dst[i] = a[i] OP b[i], for i < len.
+/// 'dst' may be the same as 'a' or 'b'. Uses AVX2 if CPU supports it.
+void xorInto( uint8_t* dst, const uint8_t* a, const uint8_t* b, size_t len );
+void orInto( uint8_t* dst, const uint8_t* a, const uint8_t* b, size_t len );
+void andInto( uint8_t* dst, const uint8_t* a, const uint8_t* b, size_t len );
+
 
 
 } // namespace Denom
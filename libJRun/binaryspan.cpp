@@ -0,0 +1,186 @@
+/// Denom.org
+///
+/// MIT No Attribution.
+///
+/// Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software
+/// without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+/// permit persons to whom the Software is furnished to do so.
+///
+/// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+/// PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+/// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+///
+/// Author:  Sergey Novochenko,  Digrol@gmail.com
+///
+/// Class BinarySpan - non-owning view of bytes.
+
+#include "stdinc.h"
+
+#include "exception.h"
+#include "binaryspan.h"
+#include "hex.h"
+#include <cstring>
+#include <type_traits>
+
+using std::wstring;
+
+namespace {
+
+// ---------------------------------------------------------------------------------------------------------------------
+/// Common implementation of Hex, hex and their narrow variants.
+template< typename StringT >
+StringT toHex( const uint8_t* p, size_t size, bool upperCase, uint32_t oneSpace, uint32_t twoSpaces, uint32_t newLine,
+	uint32_t lineShift )
+{
+	typedef typename StringT::value_type CharT;
+
+	StringT res;
+	if( size == 0 )
+	{
+		return res;
+	}
+
+	if( !oneSpace && !twoSpaces && !newLine )
+	{
+		// No separators - whole array in one step
+		std::string chars( lineShift + 2 * size, ' ' );
+		Denom::hexEncode( p, size, &chars[ lineShift ], upperCase );
+		if constexpr( std::is_same<CharT, char>::value )
+			return chars;
+		else
+			return StringT( chars.begin(), chars.end() );
+	}
+
+	const char* digits = upperCase ? "0123456789ABCDEF" : "0123456789abcdef";
+	StringT shiftStr( lineShift, CharT(' ') );
+
+	res.reserve( lineShift + size * 3 + (newLine ? (size / newLine) * (lineShift + 1) : 0) );
+	res += shiftStr;
+	res += CharT( digits[ p[ 0 ] >> 4 ] );
+	res += CharT( digits[ p[ 0 ] & 0x0F ] );
+
+	// Counters of bytes in current group instead of division
+	uint32_t inOne = 0;
+	uint32_t inTwo = 0;
+	uint32_t inLine = 0;
+	for( size_t i = 1; i < size; ++i )
+	{
+		if( ++inOne == oneSpace ) inOne = 0;
+		if( ++inTwo == twoSpaces ) inTwo = 0;
+		if( ++inLine == newLine ) inLine = 0;
+
+		if( newLine && !inLine )
+		{
+			res += CharT( '\n' );
+			res += shiftStr;
+		}
+		else if( twoSpaces && !inTwo )
+		{
+			res += CharT( ' ' );
+			res += CharT( ' ' );
+		}
+		else if( oneSpace && !inOne )
+		{
+			res += CharT( ' ' );
+		}
+		res += CharT( digits[ p[ i ] >> 4 ] );
+		res += CharT( digits[ p[ i ] & 0x0F ] );
+	}
+	return res;
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+/// BigEndian bytes to unsigned integer.
+template< typename IntT >
+IntT toUInt( const uint8_t* p, size_t size, const wchar_t* errMsg )
+{
+	MUST_M( size <= sizeof(IntT), errMsg );
+	IntT num = 0;
+	for( size_t i = 0; i < size; ++i )
+	{
+		num = (IntT)((num << 8) | p[ i ]);
+	}
+	return num;
+}
+
+} // namespace
+
+namespace Denom {
+
+// ---------------------------------------------------------------------------------------------------------------------
+wstring BinarySpan::Hex( uint32_t oneSpace, uint32_t twoSpaces, uint32_t newLine, uint32_t lineShift ) const
+{
+	return toHex<wstring>( ptr, length, true, oneSpace, twoSpaces, newLine, lineShift );
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+wstring BinarySpan::hex( uint32_t oneSpace, uint32_t twoSpaces, uint32_t newLine, uint32_t lineShift ) const
+{
+	return toHex<wstring>( ptr, length, false, oneSpace, twoSpaces, newLine, lineShift );
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+std::string BinarySpan::HexStr( uint32_t oneSpace, uint32_t twoSpaces, uint32_t newLine, uint32_t lineShift ) const
+{
+	return toHex<std::string>( ptr, length, true, oneSpace, twoSpaces, newLine, lineShift );
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+std::string BinarySpan::hexStr( uint32_t oneSpace, uint32_t twoSpaces, uint32_t newLine, uint32_t lineShift ) const
+{
+	return toHex<std::string>( ptr, length, false, oneSpace, twoSpaces, newLine, lineShift );
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+uint16_t BinarySpan::U16() const
+{
+	return toUInt<uint16_t>( ptr, length, L"Size of Binary can't be more than 2 bytes to interpret it as U16" );
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+uint32_t BinarySpan::U32() const
+{
+	return toUInt<uint32_t>( ptr, length, L"Size of Binary can't be more than 4 bytes to interpret it as U32" );
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+uint64_t BinarySpan::U64() const
+{
+	return toUInt<uint64_t>( ptr, length, L"Size of Binary can't be more than 8 bytes to interpret it as U64" );
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+BinarySpan BinarySpan::slice( size_t offset, size_t count ) const
+{
+	MUST_M( (offset <= length) && (count <= length - offset), L"Out of 'BinarySpan' borders in 'slice'" );
+	return BinarySpan( ptr + offset, count );
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+BinarySpan BinarySpan::first( size_t count ) const
+{
+	MUST_M( count <= length, L"Wrong 'count' in BinarySpan.first()" );
+	return BinarySpan( ptr, count );
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+BinarySpan BinarySpan::last( size_t count ) const
+{
+	MUST_M( count <= length, L"Wrong 'count' in BinarySpan.last()" );
+	return BinarySpan( ptr + length - count, count );
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+bool operator==( const BinarySpan& left, const BinarySpan& right )
+{
+	return (left.size() == right.size()) &&
+		((left.size() == 0) || (memcmp( left.data(), right.data(), left.size() ) == 0));
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+bool operator!=( const BinarySpan& left, const BinarySpan& right )
+{
+	return !(left == right);
+}
+
+} // namespace Denom
@@ -0,0 +1,87 @@
+/// Denom.org
+///
+/// MIT No Attribution.
+///
+/// Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software
+/// without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+/// permit persons to whom the Software is furnished to do so.
+///
+/// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+/// PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+/// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+///
+/// Author:  Sergey Novochenko,  Digrol@gmail.com
+///
+/// Class BinarySpan - non-owning view of bytes.
+
+#ifndef BINARYSPAN_H_5C81E3F0A94D2B67
+#define BINARYSPAN_H_5C81E3F0A94D2B67
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string>
+#include "binary.h"
+
+namespace Denom {
+
+// ---------------------------------------------------------------------------------------------------------------------
+/// Pointer + length of bytes, owned by someone else (Binary, MappedBinary, static array).
+/// Slices of span are spans too, so structured data can be parsed without copying and allocations.
+/// Span is valid while viewed data exists and is not reallocated.
+/// Example:
+///     MappedBinary file( L"Main.class" );
+///     BinarySpan span = file;
+///     uint32_t magic = span.first( 4 ).U32();
+class BinarySpan
+{
+public:
+	BinarySpan() {}
+	BinarySpan( const uint8_t* data, size_t size ) : ptr( data ), length( size ) {}
+	BinarySpan( const Binary& bin ) : ptr( bin.data() ), length( bin.size() ) {}
+
+	// -----------------------------------------------------------------------------------------------------------------
+	const uint8_t* data() const { return ptr; }
+	size_t size() const { return length; }
+	bool empty() const { return length == 0; }
+
+	const uint8_t* begin() const { return ptr; }
+	const uint8_t* end() const { return ptr + length; }
+
+	uint8_t operator[]( size_t index ) const { return ptr[ index ]; }
+
+	// -----------------------------------------------------------------------------------------------------------------
+	/// Same as in Binary: letters case and formatting parameters.
+	std::wstring Hex( uint32_t oneSpace = 0, uint32_t twoSpaces = 0, uint32_t newLine = 0, uint32_t lineShift = 0 ) const;
+	std::wstring hex( uint32_t oneSpace = 0, uint32_t twoSpaces = 0, uint32_t newLine = 0, uint32_t lineShift = 0 ) const;
+	std::string HexStr( uint32_t oneSpace = 0, uint32_t twoSpaces = 0, uint32_t newLine = 0, uint32_t lineShift = 0 ) const;
+	std::string hexStr( uint32_t oneSpace = 0, uint32_t twoSpaces = 0, uint32_t newLine = 0, uint32_t lineShift = 0 ) const;
+
+	// -----------------------------------------------------------------------------------------------------------------
+	/// Interpret bytes as BigEndian unsigned integer, like Binary::U16 / U32 / U64.
+	uint16_t U16() const;
+	uint32_t U32() const;
+	uint64_t U64() const;
+
+	// -----------------------------------------------------------------------------------------------------------------
+	/// Sub-views, bytes are not copied. Checking for out of bounds.
+	BinarySpan slice( size_t offset, size_t count ) const;
+	BinarySpan first( size_t count ) const;
+	BinarySpan last( size_t count ) const;
+
+	// -----------------------------------------------------------------------------------------------------------------
+	/// Copy of viewed bytes.
+	Binary toBinary() const { return Binary( begin(), end() ); }
+
+private:
+	const uint8_t* ptr = nullptr;
+	size_t length = 0;
+};
+
+// ---------------------------------------------------------------------------------------------------------------------
+/// Compare contents of spans.
+bool operator==( const BinarySpan& left, const BinarySpan& right );
+bool operator!=( const BinarySpan& left, const BinarySpan& right );
+
+} // namespace Denom
+
+#endif // Header guard
@@ -0,0 +1,199 @@
+/// Denom.org
+///
+/// MIT No Attribution.
+///
+/// Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software
+/// without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+/// permit persons to whom the Software is furnished to do so.
+///
+/// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+/// PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+/// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+///
+/// Author:  Sergey Novochenko,  Digrol@gmail.com
+///
+/// Running of child processes and replacement of current process.
+
+#include "stdinc.h"
+
+#include "childprocess.h"
+
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#ifdef _WIN32
+#include <process.h>
+#else
+#include <signal.h>
+#include <spawn.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/wait.h>
+extern char** environ;
+#endif
+
+using std::vector;
+using std::wstring;
+
+namespace {
+
+typedef Denom::NativeName::value_type NativeChar;
+
+// ---------------------------------------------------------------------------------------------------------------------
+/// argv / envp for 'strings', terminated by nullptr.
+vector<NativeChar*> pointers( vector<Denom::NativeName>& strings )
+{
+	vector<NativeChar*> result;
+	for( Denom::NativeName& s : strings )
+		result.push_back( &s[ 0 ] );
+	result.push_back( nullptr );
+	return result;
+}
+
+#ifdef _WIN32
+// ---------------------------------------------------------------------------------------------------------------------
+/// _wspawnv joins arguments with spaces, so quote arguments with spaces.
+vector<wstring> quote( const vector<wstring>& args )
+{
+	vector<wstring> quoted;
+	for( const wstring& arg : args )
+	{
+		bool needQuotes = arg.empty() || (arg.find_first_of( L" \t" ) != wstring::npos);
+		quoted.push_back( needQuotes ? L"\"" + arg + L"\"" : arg );
+	}
+	return quoted;
+}
+#endif
+
+} // namespace
+
+namespace Denom {
+
+// ---------------------------------------------------------------------------------------------------------------------
+Process::Process( const vector<wstring>& args )
+{
+	MUST_M( !args.empty(), L"Executable is not set" );
+	for( const wstring& arg : args )
+		this->args.push_back( toNative( arg ) );
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+void Process::addArgs( const vector<std::string>& args )
+{
+	for( const std::string& arg : args )
+		this->args.push_back( toNative( arg ) );
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+void Process::setEnvironment( const vector<wstring>& env )
+{
+	this->env.clear();
+	for( const wstring& var : env )
+		this->env.push_back( toNative( var ) );
+	hasEnv = true;
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+void Process::redirect( int childFd, int parentFd )
+{
+	redirects.emplace_back( childFd, parentFd );
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+void Process::start()
+{
+	MUST_M( id == 0, L"Process is already started: " + fromNative( args[ 0 ] ) );
+
+	#ifdef _WIN32
+		MUST_M( redirects.empty(), L"Redirection of descriptors is not supported on Windows" );
+		vector<wstring> quoted = quote( args );
+		vector<wchar_t*> argv = pointers( quoted );
+		vector<wchar_t*> envp = pointers( env );
+		intptr_t handle = _wspawnve( _P_NOWAIT, args[ 0 ].c_str(), argv.data(), hasEnv ? envp.data() : nullptr );
+		MUST_M( handle != -1, L"Can't run " + args[ 0 ] + L": " + s2w( strerror( errno ) ) );
+		id = handle;
+	#else
+		posix_spawn_file_actions_t actions;
+		posix_spawn_file_actions_init( &actions );
+		for( const std::pair<int, int>& r : redirects )
+			posix_spawn_file_actions_adddup2( &actions, r.second, r.first );
+
+		// Child starts with default handlers and empty mask, whatever parent has set up
+		posix_spawnattr_t attr;
+		posix_spawnattr_init( &attr );
+		sigset_t signals;
+		sigemptyset( &signals );
+		posix_spawnattr_setsigmask( &attr, &signals );
+		sigfillset( &signals );
+		sigdelset( &signals, SIGKILL );
+		sigdelset( &signals, SIGSTOP );
+		posix_spawnattr_setsigdefault( &attr, &signals );
+		posix_spawnattr_setflags( &attr, POSIX_SPAWN_SETSIGMASK | POSIX_SPAWN_SETSIGDEF );
+
+		vector<char*> argv = pointers( args );
+		vector<char*> envp = pointers( env );
+		pid_t pid = 0;
+		int err = posix_spawn( &pid, argv[ 0 ], &actions, &attr, argv.data(), hasEnv ? envp.data() : environ );
+		posix_spawnattr_destroy( &attr );
+		posix_spawn_file_actions_destroy( &actions );
+		MUST_M( err == 0, L"Can't run " + fromNative( args[ 0 ] ) + L": " + s2w( strerror( err ) ) );
+		id = pid;
+	#endif
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+int Process::wait()
+{
+	MUST_M( id != 0, L"Process is not started: " + fromNative( args[ 0 ] ) );
+
+	#ifdef _WIN32
+		int status = 0;
+		MUST_M( _cwait( &status, id, 0 ) != -1, L"Can't wait for " + args[ 0 ] );
+		id = 0;
+		return status;
+	#else
+		int status = 0;
+		while( waitpid( (pid_t)id, &status, 0 ) == -1 )
+		{
+			MUST_M( errno == EINTR, L"Can't wait for " + fromNative( args[ 0 ] ) );
+		}
+		id = 0;
+		if( WIFEXITED( status ) )
+			return WEXITSTATUS( status );
+		return 128 + WTERMSIG( status );
+	#endif
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+int Process::run()
+{
+	start();
+	return wait();
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+void Process::exec()
+{
+	#ifdef _WIN32
+		int code = run();
+		fflush( nullptr );
+		_exit( code );
+	#else
+		for( const std::pair<int, int>& r : redirects )
+		{
+			// dup2 of descriptor to itself keeps close-on-exec, 'adddup2' of posix_spawn clears it
+			bool ok = (r.first == r.second) ? (fcntl( r.first, F_SETFD, 0 ) != -1) : (dup2( r.second, r.first ) != -1);
+			MUST_M( ok, L"Can't redirect descriptor " + std::to_wstring( r.first ) );
+		}
+
+		vector<char*> argv = pointers( args );
+		vector<char*> envp = pointers( env );
+		fflush( nullptr );
+		execve( argv[ 0 ], argv.data(), hasEnv ? envp.data() : environ );
+		THROW_M( L"Can't run " + fromNative( args[ 0 ] ) + L": " + s2w( strerror( errno ) ) );
+	#endif
+}
+
+} // namespace Denom
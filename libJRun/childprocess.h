@@ -0,0 +1,81 @@
+/// Denom.org
+///
+/// MIT No Attribution.
+///
+/// Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software
+/// without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+/// permit persons to whom the Software is furnished to do so.
+///
+/// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+/// PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+/// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+///
+/// Author:  Sergey Novochenko,  Digrol@gmail.com
+///
+/// Running of child processes and replacement of current process.
+
+#ifndef CHILDPROCESS_H_3C9E05B7D1A64F82
+#define CHILDPROCESS_H_3C9E05B7D1A64F82
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <utility>
+#include "utils.h"
+
+namespace Denom {
+
+// ---------------------------------------------------------------------------------------------------------------------
+/// Process with explicit arguments and environment.
+/// On POSIX it is started by posix_spawn: child does not copy address space of parent (vfork semantics),
+/// so start costs the same for small and big parent.
+/// Example:
+///     Process javac( { L"/usr/bin/javac", L"Hello.java" } );
+///     int code = javac.run();
+class Process
+{
+public:
+	/// @param args - args[0] is path to executable, PATH is not searched.
+	explicit Process( const std::vector<std::wstring>& args );
+
+	/// Appends arguments in UTF-8, e.g. from command line. On POSIX their bytes are passed as is, even not UTF-8.
+	void addArgs( const std::vector<std::string>& args );
+
+	/// Environment of child: "NAME=value" strings. By default child inherits environment of this process.
+	void setEnvironment( const std::vector<std::wstring>& env );
+
+	/// Descriptor 'childFd' in child will be a copy of 'parentFd' of this process.
+	/// Other descriptors are inherited as usual: all except close-on-exec ones.
+	/// 'childFd' == 'parentFd' makes close-on-exec descriptor inherited. Not supported on Windows.
+	void redirect( int childFd, int parentFd );
+
+	/// Starts process. Throws Denom::Exception if it can't be started.
+	void start();
+
+	/// Waits for process, started by 'start'.
+	/// @return exit code, or 128 + number of signal, which has killed process.
+	int wait();
+
+	/// start() and wait().
+	int run();
+
+	/// Replaces current process by this one (execve): no parent stays in memory and intercepts signals.
+	/// Destructors and atexit handlers of current process are not called, stdio buffers are flushed.
+	/// Windows has no such replacement: process is run and current process exits with its exit code.
+	/// Throws Denom::Exception if process can't be started.
+	[[noreturn]] void exec();
+
+	/// pid on POSIX, process handle on Windows; 0 if process is not running.
+	intptr_t getId() const { return id; }
+
+private:
+	std::vector<NativeName> args;
+	std::vector<NativeName> env;
+	bool hasEnv = false;
+	std::vector<std::pair<int, int>> redirects;
+	intptr_t id = 0;
+};
+
+} // namespace Denom
+
+#endif // Header guard
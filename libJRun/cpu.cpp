@@ -0,0 +1,109 @@
+/// Denom.org
+///
+/// MIT No Attribution.
+///
+/// Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software
+/// without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+/// permit persons to whom the Software is furnished to do so.
+///
+/// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+/// PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+/// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+///
+/// Author:  Sergey Novochenko,  Digrol@gmail.com
+///
+/// CPU features, used for choosing SIMD implementations.
+
+#include "stdinc.h"
+
+#include "cpu.h"
+
+#ifdef DENOM_X86
+	#ifdef _MSC_VER
+		#include <intrin.h>
+	#else
+		#include <cpuid.h>
+	#endif
+#endif
+
+namespace {
+
+#ifdef DENOM_X86
+
+// ---------------------------------------------------------------------------------------------------------------------
+void cpuid( uint32_t leaf, uint32_t subLeaf, uint32_t regs[ 4 ] )
+{
+	#ifdef _MSC_VER
+		int r[ 4 ];
+		__cpuidex( r, (int)leaf, (int)subLeaf );
+		for( int i = 0; i < 4; ++i )
+			regs[ i ] = (uint32_t)r[ i ];
+	#else
+		__cpuid_count( leaf, subLeaf, regs[ 0 ], regs[ 1 ], regs[ 2 ], regs[ 3 ] );
+	#endif
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+/// Registers, saved by OS on context switch (XCR0).
+uint64_t xgetbv0()
+{
+	#ifdef _MSC_VER
+		return _xgetbv( 0 );
+	#else
+		uint32_t lo, hi;
+		__asm__ __volatile__( "xgetbv" : "=a"(lo), "=d"(hi) : "c"(0) );
+		return ((uint64_t)hi << 32) | lo;
+	#endif
+}
+
+#endif // DENOM_X86
+
+} // namespace
+
+namespace Denom {
+
+// ---------------------------------------------------------------------------------------------------------------------
+CpuFeatures::CpuFeatures()
+{
+	#ifdef DENOM_X86
+		uint32_t r[ 4 ];
+		cpuid( 0, 0, r );
+		uint32_t maxLeaf = r[ 0 ];
+		if( maxLeaf < 1 )
+			return;
+
+		cpuid( 0x80000000, 0, r );
+		if( r[ 0 ] >= 0x80000007 )
+		{
+			cpuid( 0x80000007, 0, r );
+			invariantTsc = (r[ 3 ] & (1u << 8)) != 0;
+		}
+
+		cpuid( 1, 0, r );
+		uint32_t ecx1 = r[ 2 ];
+		ssse3 = (ecx1 & (1u << 9)) != 0;
+		sse41 = (ecx1 & (1u << 19)) != 0;
+
+		if( maxLeaf < 7 )
+			return;
+
+		cpuid( 7, 0, r );
+		uint32_t ebx7 = r[ 1 ];
+
+		bool osxsave = (ecx1 & (1u << 27)) != 0;
+		bool avx = (ecx1 & (1u << 28)) != 0;
+
+		shaNi = ssse3 && sse41 && ((ebx7 & (1u << 29)) != 0);
+		// OS must save YMM registers
+		avx2 = osxsave && avx && ((xgetbv0() & 6) == 6) && ((ebx7 & (1u << 5)) != 0);
+	#endif
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+const CpuFeatures& cpuFeatures()
+{
+	static const CpuFeatures features;
+	return features;
+}
+
+} // namespace Denom
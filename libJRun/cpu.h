@@ -0,0 +1,49 @@
+/// Denom.org
+///
+/// MIT No Attribution.
+///
+/// Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software
+/// without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+/// permit persons to whom the Software is furnished to do so.
+///
+/// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+/// PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+/// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+///
+/// Author:  Sergey Novochenko,  Digrol@gmail.com
+///
+/// CPU features, used for choosing SIMD implementations.
+
+#ifndef CPU_H_C84E1B07F2D95A36
+#define CPU_H_C84E1B07F2D95A36
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+	#define DENOM_X86
+	#ifdef _MSC_VER
+		#define DENOM_TARGET( features )
+	#else
+		#define DENOM_TARGET( features ) __attribute__(( target( features ) ))
+	#endif
+#endif
+
+namespace Denom {
+
+// ---------------------------------------------------------------------------------------------------------------------
+/// Detected once, on first call. On other architectures all flags are false.
+/// Functions, compiled with DENOM_TARGET( "..." ), may be called only if CPU supports these features.
+struct CpuFeatures
+{
+	bool ssse3 = false;
+	bool sse41 = false;
+	bool avx2 = false;  // checked that OS saves YMM registers
+	bool shaNi = false; // SHA extensions
+	bool invariantTsc = false; // TSC runs at constant rate in all power states
+
+	CpuFeatures();
+};
+
+const CpuFeatures& cpuFeatures();
+
+} // namespace Denom
+
+#endif // Header guard
@@ -16,6 +16,7 @@
 
 #include "utils.h"
 #include "exception.h"
+#include "format.h"
 
 using std::string;
 using std::wstring;
@@ -482,6 +483,100 @@ void CutStackAboveFunc( list<ExStackInfo>& call_stack, const string& func_name )
 
 #endif // _WIN32
 
+#if defined(__GLIBC__) || defined(__APPLE__)
+
+#define DENOM_BACKTRACE
+#include <execinfo.h>
+#include <dlfcn.h>
+#include <cxxabi.h>
+#include <cstdlib>
+#include <mutex>
+#include <unordered_map>
+
+namespace {
+
+// =====================================================================================================================
+/// Call stack: addresses are captured at throw, names are found only when message is formatted.
+
+// ---------------------------------------------------------------------------------------------------------------------
+/// Return addresses of callers of Exception constructor.
+__attribute__(( noinline )) uint32_t captureStack( void** frames, uint32_t maxFrames )
+{
+	// This function and constructor of Exception
+	const int SKIP = 2;
+	void* buf[ Denom::Exception::MAX_FRAMES + SKIP ];
+	int count = backtrace( buf, (int)ARRAY_SIZE( buf ) );
+	uint32_t n = 0;
+	for( int i = SKIP; (i < count) && (n < maxFrames); ++i )
+		frames[ n++ ] = buf[ i ];
+	return n;
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+/// Example: "Denom::Binary::loadFromFile(std::wstring const&) + 0x1c  [/usr/bin/jrun+0x2f1a0]".
+/// Offset in module can be passed to 'addr2line -e <module>' to get file and line.
+/// Functions of executable have names only if it exports symbols (-rdynamic).
+/// Results are cached - the same addresses repeat in exceptions.
+const string& symbolize( void* address, bool& isMain )
+{
+	static std::mutex mutex;
+	static std::unordered_map< void*, string > cache;
+
+	std::lock_guard<std::mutex> lock( mutex );
+	auto it = cache.find( address );
+	if( it == cache.end() )
+	{
+		// Return address points to instruction after call, step back into call itself
+		uintptr_t pc = (uintptr_t)address - 1;
+		string text;
+		Dl_info info;
+		if( (dladdr( (void*)pc, &info ) != 0) && (info.dli_fname != nullptr) )
+		{
+			if( info.dli_sname != nullptr )
+			{
+				int status = -1;
+				char* demangled = abi::__cxa_demangle( info.dli_sname, nullptr, nullptr, &status );
+				text = (status == 0) ? demangled : info.dli_sname;
+				free( demangled );
+				Denom::formatTo( text, FMT( " + 0x{:x}" ), pc - (uintptr_t)info.dli_saddr );
+			}
+			else
+			{
+				text = "??";
+			}
+			Denom::formatTo( text, FMT( "  [{}+0x{:x}]" ), info.dli_fname, pc - (uintptr_t)info.dli_fbase );
+		}
+		else
+		{
+			Denom::formatTo( text, FMT( "??  [0x{:x}]" ), pc );
+		}
+		it = cache.emplace( address, text ).first;
+	}
+
+	isMain = it->second.compare( 0, 7, "main + " ) == 0;
+	return it->second;
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+/// Frames up to 'main', one per line.
+wstring framesToString( void* const* frames, uint32_t count )
+{
+	string s;
+	for( uint32_t i = 0; i < count; ++i )
+	{
+		bool isMain = false;
+		s += symbolize( frames[ i ], isMain );
+		s += '\n';
+		if( isMain )
+			break;
+	}
+	return Denom::s2w( s );
+}
+
+} // unnamed namespace
+
+#endif // __GLIBC__ || __APPLE__
+
 // ---------------------------------------------------------------------------------------------------------------------
 
 namespace Denom {
@@ -537,22 +632,11 @@ std::wstring FormatExceptionMessage( const Exception& ex )
 	s.append( ex.message );
 	s.append( L"\n" );
 
-	//wchar_t buf[20];
-
 	if( ex.code != 0 )
 	{
-		// TODO: cross
-		//_ultow_s( ex.code, buf, ARRAY_SIZE(buf), 10 );
-		s.append( L"Code: " );
-		//s.append( buf );
-		s.append( L" (0x" );
-		// TODO: cross
-		//_ultow_s( ex.code, buf, ARRAY_SIZE(buf), 16 );
-		//s.append( buf );
-		s.append( L")\n" );
+		s.append( s2w( format( FMT( "Code: {} (0x{:X})\n" ), ex.code, ex.code ) ) );
 	}
 
-
 	if( ex.source_info.line != 0 )
 	{
 		s.append( L"\nPlace:\n" );
@@ -581,19 +665,36 @@ std::wstring FormatExceptionMessage( const Exception& ex )
 		s.append( L"\nCall stack:\n" );
 		s.append( CallStackToString(ex.call_stack) );
 	}
+#ifdef DENOM_BACKTRACE
+	else if( ex.frame_count != 0 )
+	{
+		s.append( L"\nCall stack:\n" );
+		s.append( framesToString( ex.frames, ex.frame_count ) );
+	}
+#endif
 	return s;
 }
 
 // =============================================================================
 // Exception
 // =============================================================================
+#ifdef _DEBUG
+bool Exception::recordCallStack = true;
+#else
+bool Exception::recordCallStack = false;
+#endif
+
 // -----------------------------------------------------------------------------
 Exception::Exception( const std::wstring& message, uint32_t code, const SourceInfo& source_info )
 	: message( message ), code(code), source_info(source_info)
 {
+	frame_count = 0;
 #if defined(_DEBUG) && defined(_WIN32)
 	StackWalker().WriteStack( &call_stack );
 	CutStackAboveFunc( call_stack, __FUNCTION__ );
+#elif defined(DENOM_BACKTRACE)
+	if( recordCallStack )
+		frame_count = captureStack( frames, MAX_FRAMES );
 #endif
 }
 
@@ -601,9 +702,13 @@ Exception::Exception( const std::wstring& message, uint32_t code, const SourceIn
 Exception::Exception( const std::string& message, uint32_t code, const SourceInfo& source_info )
 	: message( s2w(message) ), code(code), source_info(source_info)
 {
+	frame_count = 0;
 #if defined(_DEBUG) && defined(_WIN32)
 	StackWalker().WriteStack( &call_stack );
 	CutStackAboveFunc( call_stack, __FUNCTION__ );
+#elif defined(DENOM_BACKTRACE)
+	if( recordCallStack )
+		frame_count = captureStack( frames, MAX_FRAMES );
 #endif
 }
 
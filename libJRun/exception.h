@@ -62,6 +62,16 @@ struct Exception
 	std::wstring message;
 	SourceInfo source_info;
 	std::list< ExStackInfo > call_stack;
+
+	/// Capture call stack of new exceptions (Linux, macOS). On in debug build; in release build stack of user error
+	/// is noise, and the first capture loads unwinder - jrun turns it on by JRUN_BACKTRACE.
+	static bool recordCallStack;
+
+	/// Return addresses, captured at creation without allocations, if 'recordCallStack' is set.
+	/// Converted to names only by FormatExceptionMessage.
+	static const uint32_t MAX_FRAMES = 32;
+	void* frames[ MAX_FRAMES ];
+	uint32_t frame_count;
 };
 
 // =============================================================================
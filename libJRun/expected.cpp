@@ -0,0 +1,55 @@
+/// Denom.org
+///
+/// MIT No Attribution.
+///
+/// Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software
+/// without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+/// permit persons to whom the Software is furnished to do so.
+///
+/// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+/// PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+/// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+///
+/// Author:  Sergey Novochenko,  Digrol@gmail.com
+///
+/// Result of operation: value or error, without exceptions and allocations.
+
+#include "stdinc.h"
+
+#include "expected.h"
+#include <cerrno>
+#include <system_error>
+
+namespace Denom {
+
+// ---------------------------------------------------------------------------------------------------------------------
+Error Error::fromErrno( const char* message, int err )
+{
+	ErrorCode code = ErrorCode::IoError;
+	if( (err == ENOENT) || (err == ENOTDIR) )
+		code = ErrorCode::NotFound;
+	else if( (err == EACCES) || (err == EPERM) )
+		code = ErrorCode::AccessDenied;
+	else if( err == ENOMEM )
+		code = ErrorCode::OutOfMemory;
+	return Error{ code, message, err };
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+std::wstring Error::toString( const std::wstring& context ) const
+{
+	std::wstring text = s2w( message ? message : "Error" );
+	if( !context.empty() )
+		text += L": " + context;
+	if( sysError != 0 )
+		text += L" (" + s2w( std::generic_category().message( sysError ) ) + L")";
+	return text;
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+void Error::raise( const std::wstring& context ) const
+{
+	THROW_C( (uint32_t)code, toString( context ) );
+}
+
+} // namespace Denom
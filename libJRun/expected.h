@@ -0,0 +1,146 @@
+/// Denom.org
+///
+/// MIT No Attribution.
+///
+/// Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software
+/// without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+/// permit persons to whom the Software is furnished to do so.
+///
+/// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+/// PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+/// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+///
+/// Author:  Sergey Novochenko,  Digrol@gmail.com
+///
+/// Result of operation: value or error, without exceptions and allocations.
+
+#ifndef EXPECTED_H_5D08F3B7A61E2C94
+#define EXPECTED_H_5D08F3B7A61E2C94
+
+#include <stdint.h>
+#include <new>
+#include <string>
+#include <type_traits>
+#include <utility>
+
+namespace Denom {
+
+// ---------------------------------------------------------------------------------------------------------------------
+enum class ErrorCode : uint32_t
+{
+	None = 0,
+	NotFound,
+	AccessDenied,
+	IoError,
+	OutOfMemory
+};
+
+// ---------------------------------------------------------------------------------------------------------------------
+/// Compact error, POD: creation and copying cost nothing.
+/// Example:  return Error{ ErrorCode::NotFound, "Can't open file", errno };
+struct Error
+{
+	ErrorCode code;
+	const char* message; // string literal
+	int sysError;        // errno, 0 if not applicable
+
+	/// Error with code by errno: ENOENT -> NotFound, EACCES -> AccessDenied and so on.
+	static Error fromErrno( const char* message, int err );
+
+	/// Example: "Can't open file: /tmp/a.txt (No such file or directory)".
+	/// @param context - appended to message, usually name of object.
+	std::wstring toString( const std::wstring& context = std::wstring() ) const;
+
+	/// Throw Denom::Exception with text 'toString( context )' and 'code'.
+	[[noreturn]] void raise( const std::wstring& context = std::wstring() ) const;
+};
+
+static_assert( std::is_trivial<Error>::value, "Error must be POD" );
+
+// ---------------------------------------------------------------------------------------------------------------------
+/// Value of type T or Error. Use for operations which fail routinely (probes, optional files), where
+/// failure must cost a branch, not an exception.
+/// Example:
+///     Expected<uint64_t> size = tryGetFileSize( name );
+///     if( !size )
+///         return size.error();
+///     use( *size );
+template< typename T >
+class Expected
+{
+public:
+	Expected( const T& value ) : ok( true ) { new( &val ) T( value ); }
+	Expected( T&& value ) : ok( true ) { new( &val ) T( std::move( value ) ); }
+	Expected( const Error& error ) : ok( false ) { err = error; }
+
+	Expected( const Expected& other ) : ok( other.ok )
+	{
+		if( ok )
+			new( &val ) T( other.val );
+		else
+			err = other.err;
+	}
+
+	Expected( Expected&& other ) : ok( other.ok )
+	{
+		if( ok )
+			new( &val ) T( std::move( other.val ) );
+		else
+			err = other.err;
+	}
+
+	Expected& operator=( Expected other )
+	{
+		this->~Expected();
+		new( this ) Expected( std::move( other ) );
+		return *this;
+	}
+
+	~Expected()
+	{
+		if( ok )
+			val.~T();
+	}
+
+	// -----------------------------------------------------------------------------------------------------------------
+	bool hasValue() const { return ok; }
+	explicit operator bool() const { return ok; }
+
+	/// @return value or throw Denom::Exception, if there is error.
+	T& value() &
+	{
+		if( !ok )
+			err.raise();
+		return val;
+	}
+
+	const T& value() const &
+	{
+		if( !ok )
+			err.raise();
+		return val;
+	}
+
+	T valueOr( const T& defaultValue ) const { return ok ? val : defaultValue; }
+
+	/// Without check, call only if 'hasValue'.
+	T& operator*() { return val; }
+	const T& operator*() const { return val; }
+	T* operator->() { return &val; }
+	const T* operator->() const { return &val; }
+
+	/// Call only if not 'hasValue'.
+	const Error& error() const { return err; }
+
+private:
+	bool ok;
+	union
+	{
+		T val;
+		Error err;
+	};
+};
+
+} // namespace Denom
+
+#endif // Header guard
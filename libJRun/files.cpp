@@ -0,0 +1,364 @@
+/// Denom.org
+///
+/// MIT No Attribution.
+///
+/// Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software
+/// without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+/// permit persons to whom the Software is furnished to do so.
+///
+/// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+/// PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+/// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+///
+/// Author:  Sergey Novochenko,  Digrol@gmail.com
+///
+/// File operations: atomic writing and copying.
+
+#include "stdinc.h"
+
+#include "files.h"
+
+#include <atomic>
+#include <cerrno>
+#include <sys/stat.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <process.h>
+#include <io.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#ifdef __linux__
+#include <sys/ioctl.h>
+#include <sys/sendfile.h>
+#include <linux/fs.h>
+#endif
+
+using std::string;
+using std::wstring;
+using Denom::NativeName;
+using Denom::fromNative;
+using Denom::Expected;
+using Denom::Error;
+
+namespace {
+
+std::atomic<uint32_t> tempCounter( 0 );
+
+// ---------------------------------------------------------------------------------------------------------------------
+/// Name of temporary file near 'filename'. Unique for process and call.
+NativeName tempNameFor( const NativeName& filename )
+{
+	#ifdef _WIN32
+		return filename + L".tmp" + std::to_wstring( _getpid() ) + L"." + std::to_wstring( ++tempCounter );
+	#else
+		return filename + ".tmp" + std::to_string( getpid() ) + "." + std::to_string( ++tempCounter );
+	#endif
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+/// Replace 'to' with 'from'.
+bool replaceFile( const NativeName& from, const NativeName& to )
+{
+	#ifdef _WIN32
+		return MoveFileExW( from.c_str(), to.c_str(), MOVEFILE_REPLACE_EXISTING ) != FALSE;
+	#else
+		return rename( from.c_str(), to.c_str() ) == 0;
+	#endif
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+void removeFile( const NativeName& filename )
+{
+	#ifdef _WIN32
+		_wremove( filename.c_str() );
+	#else
+		unlink( filename.c_str() );
+	#endif
+}
+
+#ifndef _WIN32
+
+// ---------------------------------------------------------------------------------------------------------------------
+bool writeAll( int fd, const uint8_t* data, size_t size )
+{
+	while( size != 0 )
+	{
+		ssize_t written = write( fd, data, size );
+		if( written < 0 )
+		{
+			if( errno == EINTR )
+				continue;
+			return false;
+		}
+		data += written;
+		size -= (size_t)written;
+	}
+	return true;
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+/// Copy regular file of 'size' bytes from current position of 'src' to 'dst'. Try kernel-side ways, then read/write.
+/// 'size' == 0 - special or empty file (/proc, FIFO): its size is unknown, it is copied by read/write till end.
+/// @return false on error or if regular file has ended before 'size' bytes.
+bool copyFd( int src, int dst, uint64_t size )
+{
+	uint64_t left = size;
+
+	#ifdef __linux__
+		bool useKernel = (size != 0);
+
+		// Clone: file shares extents with source, no data is copied (Btrfs, XFS)
+		if( useKernel && (ioctl( dst, FICLONE, src ) == 0) )
+			return true;
+
+		while( (left != 0) && useKernel )
+		{
+			ssize_t copied = copy_file_range( src, NULL, dst, NULL, (size_t)std::min<uint64_t>( left, 1 << 30 ), 0 );
+			if( copied > 0 )
+			{
+				left -= (uint64_t)copied;
+				continue;
+			}
+			if( copied == 0 )
+				break; // premature end - checked by read/write below
+			if( errno == EINTR )
+				continue;
+			// Different file systems on old kernels, unsupported file system, etc.
+			if( (errno == EXDEV) || (errno == ENOSYS) || (errno == EINVAL) || (errno == EOPNOTSUPP) )
+				break;
+			return false;
+		}
+
+		while( (left != 0) && useKernel )
+		{
+			ssize_t copied = sendfile( dst, src, NULL, (size_t)std::min<uint64_t>( left, 1 << 30 ) );
+			if( copied > 0 )
+			{
+				left -= (uint64_t)copied;
+				continue;
+			}
+			if( copied == 0 )
+				break;
+			if( errno == EINTR )
+				continue;
+			if( (errno == EINVAL) || (errno == ENOSYS) )
+				break;
+			return false;
+		}
+		if( useKernel && (left == 0) )
+			return true;
+	#endif
+
+	std::vector<uint8_t> buf( 1 << 20 );
+	for( ;; )
+	{
+		ssize_t bytesRead = read( src, buf.data(), buf.size() );
+		if( bytesRead < 0 )
+		{
+			if( errno == EINTR )
+				continue;
+			return false;
+		}
+		if( bytesRead == 0 )
+			return (size == 0) || (left == 0);
+		if( !writeAll( dst, buf.data(), (size_t)bytesRead ) )
+			return false;
+		left -= std::min<uint64_t>( left, (uint64_t)bytesRead );
+	}
+}
+
+#endif // !_WIN32
+
+// ---------------------------------------------------------------------------------------------------------------------
+Expected<uint64_t> fileSizeNative( const NativeName& filename )
+{
+	#ifdef _WIN32
+		struct __stat64 fileStat;
+		bool ok = _wstat64( filename.c_str(), &fileStat ) == 0;
+	#else
+		struct stat fileStat;
+		bool ok = stat( filename.c_str(), &fileStat ) == 0;
+	#endif
+	if( !ok )
+		return Error::fromErrno( "Can't get file size", errno );
+	return (uint64_t)fileStat.st_size;
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+uint64_t fileSizeOrThrow( const NativeName& filename )
+{
+	Expected<uint64_t> size = fileSizeNative( filename );
+	if( !size )
+		size.error().raise( fromNative( filename ) );
+	return *size;
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+/// Write to file in place: existing file is truncated, its permissions and symlinks to it are kept.
+void writeInPlaceNative( const NativeName& filename, const uint8_t* data, size_t size )
+{
+	#ifdef _WIN32
+		FILE* f = _wfopen( filename.c_str(), L"wb" );
+	#else
+		FILE* f = fopen( filename.c_str(), "wb" );
+	#endif
+	MUST_M( f != NULL, L"Can't open file: " + fromNative( filename ) );
+
+	size_t written = (size != 0) ? fwrite( data, 1, size, f ) : 0;
+	bool ok = (fflush( f ) == 0) && (written == size);
+	ok = (fclose( f ) == 0) && ok;
+	MUST_M( ok, L"Can't write file: " + fromNative( filename ) );
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+void writeNative( const NativeName& filename, const uint8_t* data, size_t size )
+{
+	// Only regular file can be replaced: symlink, device (/dev/null, /dev/stdout), FIFO are written in place
+	#ifdef _WIN32
+		struct __stat64 target;
+		bool exists = _wstat64( filename.c_str(), &target ) == 0;
+		if( exists && ((target.st_mode & _S_IFMT) != _S_IFREG) )
+			return writeInPlaceNative( filename, data, size );
+	#else
+		struct stat target;
+		bool exists = lstat( filename.c_str(), &target ) == 0;
+		if( exists && !S_ISREG( target.st_mode ) )
+			return writeInPlaceNative( filename, data, size );
+	#endif
+
+	NativeName tempName = tempNameFor( filename );
+
+	// Data reaches disk before rename: after crash file is either old or the whole new one, not empty
+	#ifdef _WIN32
+		FILE* f = _wfopen( tempName.c_str(), L"wb" );
+		MUST_M( f != NULL, L"Can't create file: " + fromNative( tempName ) );
+		size_t written = (size != 0) ? fwrite( data, 1, size, f ) : 0;
+		bool ok = (fflush( f ) == 0) && (written == size) && (_commit( _fileno( f ) ) == 0);
+		ok = (fclose( f ) == 0) && ok;
+		if( ok && exists )
+			ok = _wchmod( tempName.c_str(), target.st_mode & (_S_IREAD | _S_IWRITE) ) == 0;
+	#else
+		int fd = open( tempName.c_str(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0666 );
+		MUST_M( fd != -1, L"Can't create file: " + fromNative( tempName ) );
+		bool ok = writeAll( fd, data, size );
+		if( ok && exists )
+			ok = fchmod( fd, target.st_mode & 07777 ) == 0;
+		ok = ok && (fsync( fd ) == 0);
+		ok = (close( fd ) == 0) && ok;
+	#endif
+
+	if( !ok || !replaceFile( tempName, filename ) )
+	{
+		removeFile( tempName );
+		THROW_M( L"Can't write file: " + fromNative( filename ) );
+	}
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+void copyNative( const NativeName& from, const NativeName& to )
+{
+	NativeName tempName = tempNameFor( to );
+
+	#ifdef _WIN32
+		bool ok = CopyFileW( from.c_str(), tempName.c_str(), TRUE ) != FALSE;
+		MUST_M( ok, L"Can't copy file " + fromNative( from ) + L" to " + fromNative( to ) );
+	#else
+		int src = open( from.c_str(), O_RDONLY | O_CLOEXEC );
+		MUST_M( src != -1, L"Can't open file: " + fromNative( from ) );
+
+		struct stat srcStat;
+		if( fstat( src, &srcStat ) != 0 )
+		{
+			close( src );
+			THROW_M( L"Can't get file size: " + fromNative( from ) );
+		}
+
+		int dst = open( tempName.c_str(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, srcStat.st_mode & 07777 );
+		if( dst == -1 )
+		{
+			close( src );
+			THROW_M( L"Can't create file: " + fromNative( tempName ) );
+		}
+
+		uint64_t size = S_ISREG( srcStat.st_mode ) ? (uint64_t)srcStat.st_size : 0;
+		bool ok = copyFd( src, dst, size ) && (fsync( dst ) == 0);
+		close( src );
+		ok = (close( dst ) == 0) && ok;
+	#endif
+
+	if( !ok || !replaceFile( tempName, to ) )
+	{
+		removeFile( tempName );
+		THROW_M( L"Can't copy file " + fromNative( from ) + L" to " + fromNative( to ) );
+	}
+}
+
+} // namespace
+
+namespace Denom {
+
+// ---------------------------------------------------------------------------------------------------------------------
+uint64_t getFileSize( const wstring& filename )
+{
+	return fileSizeOrThrow( toNative( filename ) );
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+uint64_t getFileSize( std::string_view filename )
+{
+	return fileSizeOrThrow( toNative( filename ) );
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+Expected<uint64_t> tryGetFileSize( const wstring& filename )
+{
+	return fileSizeNative( toNative( filename ) );
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+Expected<uint64_t> tryGetFileSize( std::string_view filename )
+{
+	return fileSizeNative( toNative( filename ) );
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+void writeFileAtomic( const wstring& filename, const uint8_t* data, size_t size )
+{
+	writeNative( toNative( filename ), data, size );
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+void writeFileAtomic( std::string_view filename, const uint8_t* data, size_t size )
+{
+	writeNative( toNative( filename ), data, size );
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+void writeFile( const wstring& filename, const uint8_t* data, size_t size )
+{
+	writeInPlaceNative( toNative( filename ), data, size );
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+void writeFile( std::string_view filename, const uint8_t* data, size_t size )
+{
+	writeInPlaceNative( toNative( filename ), data, size );
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+void copyFile( const wstring& from, const wstring& to )
+{
+	copyNative( toNative( from ), toNative( to ) );
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+void copyFile( std::string_view from, std::string_view to )
+{
+	copyNative( toNative( from ), toNative( to ) );
+}
+
+} // namespace Denom
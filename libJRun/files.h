@@ -0,0 +1,61 @@
+/// Denom.org
+///
+/// MIT No Attribution.
+///
+/// Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software
+/// without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+/// permit persons to whom the Software is furnished to do so.
+///
+/// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+/// PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+/// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+///
+/// Author:  Sergey Novochenko,  Digrol@gmail.com
+///
+/// File operations: atomic writing and copying.
+/// File names are std::wstring or std::string_view in UTF-8, which is passed to OS as is on Linux, see 'NativeName'.
+
+#ifndef FILES_H_71B3E0D4A95C2F68
+#define FILES_H_71B3E0D4A95C2F68
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string>
+#include <string_view>
+#include "expected.h"
+
+namespace Denom {
+
+// ---------------------------------------------------------------------------------------------------------------------
+/// Size of file in bytes.
+uint64_t getFileSize( const std::wstring& filename );
+uint64_t getFileSize( std::string_view filename );
+
+/// Non-throwing variants, for files which may be absent.
+Expected<uint64_t> tryGetFileSize( const std::wstring& filename );
+Expected<uint64_t> tryGetFileSize( std::string_view filename );
+
+// ---------------------------------------------------------------------------------------------------------------------
+/// Write data to file in place: existing file is truncated, its permissions are kept, symlinks are followed.
+void writeFile( const std::wstring& filename, const uint8_t* data, size_t size );
+void writeFile( std::string_view filename, const uint8_t* data, size_t size );
+
+// ---------------------------------------------------------------------------------------------------------------------
+/// Write data to file atomically: for cache artifacts and other files, read by concurrent processes.
+/// Data is written to temporary file in the same directory and flushed to disk, then temporary file gets permissions
+/// of existing file and replaces 'filename', so readers see either old file or the whole new one, even after crash.
+/// Symlinks and special files (/dev/null, FIFO) are not replaced, but written in place, like in 'writeFile'.
+void writeFileAtomic( const std::wstring& filename, const uint8_t* data, size_t size );
+void writeFileAtomic( std::string_view filename, const uint8_t* data, size_t size );
+
+// ---------------------------------------------------------------------------------------------------------------------
+/// Copy file body without passing it through user space.
+/// Linux: clone (reflink) on file systems which support it, otherwise 'copy_file_range' or 'sendfile'.
+/// Destination file is flushed to disk and replaced atomically, like in 'writeFileAtomic'.
+/// Permissions of destination are the same as of source.
+void copyFile( const std::wstring& from, const std::wstring& to );
+void copyFile( std::string_view from, std::string_view to );
+
+} // namespace Denom
+
+#endif // Header guard
@@ -0,0 +1,149 @@
+/// Denom.org
+///
+/// MIT No Attribution.
+///
+/// Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software
+/// without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+/// permit persons to whom the Software is furnished to do so.
+///
+/// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+/// PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+/// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+///
+/// Author:  Sergey Novochenko,  Digrol@gmail.com
+///
+/// Type-safe formatting with format strings, checked by compiler.
+
+#include "stdinc.h"
+
+#include "format.h"
+#include "utf8.h"
+#include <charconv>
+
+namespace {
+
+using Denom::FormatArg;
+
+// ---------------------------------------------------------------------------------------------------------------------
+void appendHex( std::string& out, uint64_t value, bool upper )
+{
+	const char* digits = upper ? "0123456789ABCDEF" : "0123456789abcdef";
+	char buf[ 16 ];
+	char* p = buf + sizeof( buf );
+	do
+	{
+		*--p = digits[ value & 0xF ];
+		value >>= 4;
+	} while( value != 0 );
+	out.append( p, buf + sizeof( buf ) - p );
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+template< typename T >
+void appendNumber( std::string& out, T value )
+{
+	char buf[ 32 ];
+	std::to_chars_result res = std::to_chars( buf, buf + sizeof( buf ), value );
+	out.append( buf, res.ptr - buf );
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+/// @param hex - 0 - decimal, 'x' or 'X' - hexadecimal.
+void appendArg( std::string& out, const FormatArg& arg, char hex )
+{
+	switch( arg.type )
+	{
+		case FormatArg::INT:
+			if( hex )
+				appendHex( out, arg.u, hex == 'X' );
+			else
+				appendNumber( out, arg.i );
+			break;
+
+		case FormatArg::UINT:
+			if( hex )
+				appendHex( out, arg.u, hex == 'X' );
+			else
+				appendNumber( out, arg.u );
+			break;
+
+		case FormatArg::DOUBLE:
+			appendNumber( out, arg.d );
+			break;
+
+		case FormatArg::BOOL:
+			out += arg.u ? "true" : "false";
+			break;
+
+		case FormatArg::CHAR:
+			out += (char)arg.u;
+			break;
+
+		case FormatArg::TEXT:
+			out.append( arg.text.ptr, arg.text.size );
+			break;
+
+		case FormatArg::WTEXT:
+		{
+			thread_local std::string utf8;
+			Denom::wideToUtf8( arg.wtext.ptr, arg.wtext.size, utf8 );
+			out += utf8;
+			break;
+		}
+
+		case FormatArg::POINTER:
+			out += "0x";
+			appendHex( out, (uint64_t)(uintptr_t)arg.p, hex == 'X' );
+			break;
+	}
+}
+
+} // namespace
+
+namespace Denom {
+
+// ---------------------------------------------------------------------------------------------------------------------
+void vformatTo( std::string& out, std::string_view format, const FormatArg* args, size_t count )
+{
+	size_t argIndex = 0;
+	size_t i = 0;
+	while( i < format.size() )
+	{
+		// Copy text up to the next brace at once
+		size_t next = format.find_first_of( "{}", i );
+		if( next == std::string_view::npos )
+		{
+			out.append( format.data() + i, format.size() - i );
+			break;
+		}
+		out.append( format.data() + i, next - i );
+		i = next;
+
+		char c = format[ i ];
+		char nextChar = (i + 1 < format.size()) ? format[ i + 1 ] : 0;
+		if( nextChar == c )
+		{
+			out += c;
+			i += 2;
+		}
+		else if( (c == '{') && (nextChar == '}') )
+		{
+			if( argIndex < count )
+				appendArg( out, args[ argIndex++ ], 0 );
+			i += 2;
+		}
+		else if( (format.substr( i, 4 ) == "{:x}") || (format.substr( i, 4 ) == "{:X}") )
+		{
+			if( argIndex < count )
+				appendArg( out, args[ argIndex++ ], format[ i + 2 ] );
+			i += 4;
+		}
+		else
+		{
+			out += c;
+			++i;
+		}
+	}
+}
+
+} // namespace Denom
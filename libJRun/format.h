@@ -0,0 +1,153 @@
+/// Denom.org
+///
+/// MIT No Attribution.
+///
+/// Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software
+/// without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+/// permit persons to whom the Software is furnished to do so.
+///
+/// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+/// PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+/// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+///
+/// Author:  Sergey Novochenko,  Digrol@gmail.com
+///
+/// Type-safe formatting with format strings, checked by compiler.
+
+#ifndef FORMAT_H_B6E2D90F1C7A4358
+#define FORMAT_H_B6E2D90F1C7A4358
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+// ---------------------------------------------------------------------------------------------------------------------
+/// Format string: literal in UTF-8.
+/// '{}' - place for the next argument, '{:x}' / '{:X}' - integer or pointer in hex, '{{' and '}}' - braces.
+/// Number of places and arguments, and braces are checked at compile time.
+/// Example:  std::string s = format( FMT( "{} of {} files, code {:X}" ), done, total, code );
+#define FMT( literal ) \
+	( [] { \
+		struct Literal : Denom::FormatLiteral \
+		{ \
+			static constexpr std::string_view text() { return literal; } \
+		}; \
+		return Literal(); \
+	}() )
+
+namespace Denom {
+
+/// Base of types, created by FMT.
+struct FormatLiteral {};
+
+template< typename T >
+using EnableIfFormat = typename std::enable_if< std::is_base_of< FormatLiteral, T >::value, int >::type;
+
+// ---------------------------------------------------------------------------------------------------------------------
+/// Result of parsing format string at compile time.
+struct FormatCheck
+{
+	size_t count = 0;   // number of places for arguments
+	bool valid = true;  // braces are paired, specifiers are known
+};
+
+constexpr FormatCheck checkFormat( std::string_view format )
+{
+	FormatCheck check;
+	for( size_t i = 0; i < format.size(); ++i )
+	{
+		char c = format[ i ];
+		if( (c == '{') && (i + 1 < format.size()) && (format[ i + 1 ] == '{') )
+		{
+			++i;
+		}
+		else if( (c == '}') && (i + 1 < format.size()) && (format[ i + 1 ] == '}') )
+		{
+			++i;
+		}
+		else if( (c == '{') && (i + 1 < format.size()) && (format[ i + 1 ] == '}') )
+		{
+			++check.count;
+			++i;
+		}
+		else if( (c == '{') && (i + 3 < format.size()) && (format[ i + 1 ] == ':') &&
+			((format[ i + 2 ] == 'x') || (format[ i + 2 ] == 'X')) && (format[ i + 3 ] == '}') )
+		{
+			++check.count;
+			i += 3;
+		}
+		else if( (c == '{') || (c == '}') )
+		{
+			check.valid = false;
+		}
+	}
+	return check;
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+/// Argument of formatting, holds value or reference to string.
+struct FormatArg
+{
+	enum Type : uint8_t { INT, UINT, DOUBLE, BOOL, CHAR, TEXT, WTEXT, POINTER };
+
+	struct Text { const char* ptr; size_t size; };
+	struct WText { const wchar_t* ptr; size_t size; };
+
+	Type type;
+	union
+	{
+		int64_t i;
+		uint64_t u;
+		double d;
+		const void* p;
+		Text text;
+		WText wtext;
+	};
+
+	FormatArg() : type( INT ), i( 0 ) {}
+	FormatArg( bool v ) : type( BOOL ), u( v ) {}
+	FormatArg( char v ) : type( CHAR ), u( (uint8_t)v ) {}
+	FormatArg( double v ) : type( DOUBLE ), d( v ) {}
+	FormatArg( float v ) : type( DOUBLE ), d( v ) {}
+	FormatArg( const void* v ) : type( POINTER ), p( v ) {}
+	FormatArg( const char* v ) : type( TEXT ), text{ v ? v : "", v ? std::char_traits<char>::length( v ) : 0 } {}
+	FormatArg( std::string_view v ) : type( TEXT ), text{ v.data(), v.size() } {}
+	FormatArg( const std::string& v ) : type( TEXT ), text{ v.data(), v.size() } {}
+	FormatArg( const wchar_t* v ) : type( WTEXT ), wtext{ v ? v : L"", v ? std::char_traits<wchar_t>::length( v ) : 0 } {}
+	FormatArg( const std::wstring& v ) : type( WTEXT ), wtext{ v.data(), v.size() } {}
+
+	template< typename T, typename std::enable_if< std::is_integral<T>::value, int >::type = 0 >
+	FormatArg( T v ) : type( std::is_signed<T>::value ? INT : UINT ), u( (uint64_t)v ) {}
+};
+
+// ---------------------------------------------------------------------------------------------------------------------
+/// Appends formatted text to 'out', format is not checked. Wide strings are converted to UTF-8.
+void vformatTo( std::string& out, std::string_view format, const FormatArg* args, size_t count );
+
+// ---------------------------------------------------------------------------------------------------------------------
+/// Appends formatted text to 'out'. Reuse 'out' to format without allocations.
+template< typename Literal, typename... Args, EnableIfFormat<Literal> = 0 >
+void formatTo( std::string& out, Literal, const Args&... args )
+{
+	constexpr FormatCheck check = checkFormat( Literal::text() );
+	static_assert( check.valid, "Wrong braces in format string" );
+	static_assert( check.count == sizeof...( Args ), "Number of '{}' in format string differs from number of arguments" );
+
+	const FormatArg formatArgs[ sizeof...( Args ) + 1 ] = { FormatArg( args )... };
+	vformatTo( out, Literal::text(), formatArgs, sizeof...( Args ) );
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+template< typename Literal, typename... Args, EnableIfFormat<Literal> = 0 >
+std::string format( Literal fmt, const Args&... args )
+{
+	std::string out;
+	formatTo( out, fmt, args... );
+	return out;
+}
+
+} // namespace Denom
+
+#endif // Header guard
@@ -0,0 +1,240 @@
+/// Denom.org
+///
+/// MIT No Attribution.
+///
+/// Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software
+/// without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+/// permit persons to whom the Software is furnished to do so.
+///
+/// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+/// PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+/// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+///
+/// Author:  Sergey Novochenko,  Digrol@gmail.com
+///
+/// Fast conversion of bytes to HEX-characters and back.
+
+#include "stdinc.h"
+
+#include "hex.h"
+#include "cpu.h"
+
+#ifdef DENOM_X86
+#include <immintrin.h>
+#endif
+
+namespace {
+
+const char HEX_UPPER[] = "0123456789ABCDEF";
+const char HEX_LOWER[] = "0123456789abcdef";
+
+// ---------------------------------------------------------------------------------------------------------------------
+/// HEX-character -> nibble, 0xFF for wrong symbols.
+struct NibbleTable
+{
+	uint8_t values[ 256 ];
+
+	NibbleTable()
+	{
+		memset( values, 0xFF, sizeof(values) );
+		for( int i = 0; i < 10; ++i )
+			values[ '0' + i ] = (uint8_t)i;
+		for( int i = 0; i < 6; ++i )
+		{
+			values[ 'A' + i ] = (uint8_t)(10 + i);
+			values[ 'a' + i ] = (uint8_t)(10 + i);
+		}
+	}
+};
+
+const NibbleTable nibbles;
+
+// ---------------------------------------------------------------------------------------------------------------------
+void encodeScalar( const uint8_t* data, size_t size, char* out, const char* digits )
+{
+	for( size_t i = 0; i < size; ++i )
+	{
+		out[ 0 ] = digits[ data[ i ] >> 4 ];
+		out[ 1 ] = digits[ data[ i ] & 0x0F ];
+		out += 2;
+	}
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+bool decodeScalar( const char* hex, size_t count, uint8_t* out )
+{
+	uint8_t wrong = 0;
+	for( size_t i = 0; i < count; i += 2 )
+	{
+		uint8_t hi = nibbles.values[ (uint8_t)hex[ i ] ];
+		uint8_t lo = nibbles.values[ (uint8_t)hex[ i + 1 ] ];
+		wrong |= (hi | lo) & 0xF0;
+		*out++ = (uint8_t)((hi << 4) | (lo & 0x0F));
+	}
+	return wrong == 0;
+}
+
+#ifdef DENOM_X86
+
+// ---------------------------------------------------------------------------------------------------------------------
+/// 16 bytes -> 32 chars per step. Returns number of processed bytes.
+DENOM_TARGET( "ssse3" )
+size_t encodeSsse3( const uint8_t* data, size_t size, char* out, const char* digits )
+{
+	const __m128i lut = _mm_loadu_si128( (const __m128i*)digits );
+	const __m128i mask = _mm_set1_epi8( 0x0F );
+
+	size_t i = 0;
+	for( ; i + 16 <= size; i += 16 )
+	{
+		__m128i v = _mm_loadu_si128( (const __m128i*)(data + i) );
+		__m128i hi = _mm_shuffle_epi8( lut, _mm_and_si128( _mm_srli_epi16( v, 4 ), mask ) );
+		__m128i lo = _mm_shuffle_epi8( lut, _mm_and_si128( v, mask ) );
+		_mm_storeu_si128( (__m128i*)(out + 2 * i), _mm_unpacklo_epi8( hi, lo ) );
+		_mm_storeu_si128( (__m128i*)(out + 2 * i + 16), _mm_unpackhi_epi8( hi, lo ) );
+	}
+	return i;
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+/// 32 bytes -> 64 chars per step.
+DENOM_TARGET( "avx2" )
+size_t encodeAvx2( const uint8_t* data, size_t size, char* out, const char* digits )
+{
+	const __m256i lut = _mm256_broadcastsi128_si256( _mm_loadu_si128( (const __m128i*)digits ) );
+	const __m256i mask = _mm256_set1_epi8( 0x0F );
+
+	size_t i = 0;
+	for( ; i + 32 <= size; i += 32 )
+	{
+		__m256i v = _mm256_loadu_si256( (const __m256i*)(data + i) );
+		__m256i hi = _mm256_shuffle_epi8( lut, _mm256_and_si256( _mm256_srli_epi16( v, 4 ), mask ) );
+		__m256i lo = _mm256_shuffle_epi8( lut, _mm256_and_si256( v, mask ) );
+		// unpack works inside 128-bit lanes: restore order of lanes
+		__m256i a = _mm256_unpacklo_epi8( hi, lo );
+		__m256i b = _mm256_unpackhi_epi8( hi, lo );
+		_mm256_storeu_si256( (__m256i*)(out + 2 * i), _mm256_permute2x128_si256( a, b, 0x20 ) );
+		_mm256_storeu_si256( (__m256i*)(out + 2 * i + 32), _mm256_permute2x128_si256( a, b, 0x31 ) );
+	}
+	return i;
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+/// 16 chars -> 16 nibbles, 'valid' - mask of HEX-symbols.
+DENOM_TARGET( "ssse3" )
+inline __m128i nibbles16( __m128i c, __m128i& valid )
+{
+	__m128i digit = _mm_sub_epi8( c, _mm_set1_epi8( '0' ) );
+	__m128i letter = _mm_sub_epi8( _mm_or_si128( c, _mm_set1_epi8( 0x20 ) ), _mm_set1_epi8( 'a' ) );
+	__m128i isDigit = _mm_cmpeq_epi8( _mm_min_epu8( digit, _mm_set1_epi8( 9 ) ), digit );
+	__m128i isLetter = _mm_cmpeq_epi8( _mm_min_epu8( letter, _mm_set1_epi8( 5 ) ), letter );
+	valid = _mm_or_si128( isDigit, isLetter );
+	return _mm_or_si128( _mm_and_si128( isDigit, digit ),
+		_mm_and_si128( isLetter, _mm_add_epi8( letter, _mm_set1_epi8( 10 ) ) ) );
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+/// 32 chars -> 16 bytes per step. Returns number of processed chars or SIZE_MAX if wrong symbol found.
+DENOM_TARGET( "ssse3" )
+size_t decodeSsse3( const char* hex, size_t count, uint8_t* out )
+{
+	// high nibble * 16 + low nibble
+	const __m128i weights = _mm_set1_epi16( 0x0110 );
+
+	size_t i = 0;
+	for( ; i + 32 <= count; i += 32 )
+	{
+		__m128i valid0, valid1;
+		__m128i n0 = nibbles16( _mm_loadu_si128( (const __m128i*)(hex + i) ), valid0 );
+		__m128i n1 = nibbles16( _mm_loadu_si128( (const __m128i*)(hex + i + 16) ), valid1 );
+		if( _mm_movemask_epi8( _mm_and_si128( valid0, valid1 ) ) != 0xFFFF )
+			return SIZE_MAX;
+
+		__m128i b0 = _mm_maddubs_epi16( n0, weights );
+		__m128i b1 = _mm_maddubs_epi16( n1, weights );
+		_mm_storeu_si128( (__m128i*)(out + i / 2), _mm_packus_epi16( b0, b1 ) );
+	}
+	return i;
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+DENOM_TARGET( "avx2" )
+inline __m256i nibbles32( __m256i c, __m256i& valid )
+{
+	__m256i digit = _mm256_sub_epi8( c, _mm256_set1_epi8( '0' ) );
+	__m256i letter = _mm256_sub_epi8( _mm256_or_si256( c, _mm256_set1_epi8( 0x20 ) ), _mm256_set1_epi8( 'a' ) );
+	__m256i isDigit = _mm256_cmpeq_epi8( _mm256_min_epu8( digit, _mm256_set1_epi8( 9 ) ), digit );
+	__m256i isLetter = _mm256_cmpeq_epi8( _mm256_min_epu8( letter, _mm256_set1_epi8( 5 ) ), letter );
+	valid = _mm256_or_si256( isDigit, isLetter );
+	return _mm256_or_si256( _mm256_and_si256( isDigit, digit ),
+		_mm256_and_si256( isLetter, _mm256_add_epi8( letter, _mm256_set1_epi8( 10 ) ) ) );
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+/// 64 chars -> 32 bytes per step.
+DENOM_TARGET( "avx2" )
+size_t decodeAvx2( const char* hex, size_t count, uint8_t* out )
+{
+	const __m256i weights = _mm256_set1_epi16( 0x0110 );
+
+	size_t i = 0;
+	for( ; i + 64 <= count; i += 64 )
+	{
+		__m256i valid0, valid1;
+		__m256i n0 = nibbles32( _mm256_loadu_si256( (const __m256i*)(hex + i) ), valid0 );
+		__m256i n1 = nibbles32( _mm256_loadu_si256( (const __m256i*)(hex + i + 32) ), valid1 );
+		if( _mm256_movemask_epi8( _mm256_and_si256( valid0, valid1 ) ) != -1 )
+			return SIZE_MAX;
+
+		__m256i b0 = _mm256_maddubs_epi16( n0, weights );
+		__m256i b1 = _mm256_maddubs_epi16( n1, weights );
+		// pack works inside 128-bit lanes: restore order of quarters
+		__m256i packed = _mm256_packus_epi16( b0, b1 );
+		_mm256_storeu_si256( (__m256i*)(out + i / 2), _mm256_permute4x64_epi64( packed, 0xD8 ) );
+	}
+	return i;
+}
+
+#endif // DENOM_X86
+
+} // namespace
+
+namespace Denom {
+
+// ---------------------------------------------------------------------------------------------------------------------
+void hexEncode( const uint8_t* data, size_t size, char* out, bool upperCase )
+{
+	const char* digits = upperCase ? HEX_UPPER : HEX_LOWER;
+	size_t done = 0;
+
+	#ifdef DENOM_X86
+		if( cpuFeatures().avx2 )
+			done = encodeAvx2( data, size, out, digits );
+		else if( cpuFeatures().ssse3 )
+			done = encodeSsse3( data, size, out, digits );
+	#endif
+
+	encodeScalar( data + done, size - done, out + 2 * done, digits );
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+bool hexDecode( const char* hex, size_t count, uint8_t* out )
+{
+	if( count & 1 )
+		return false;
+
+	size_t done = 0;
+
+	#ifdef DENOM_X86
+		if( cpuFeatures().avx2 )
+			done = decodeAvx2( hex, count, out );
+		else if( cpuFeatures().ssse3 )
+			done = decodeSsse3( hex, count, out );
+		if( done == SIZE_MAX )
+			return false;
+	#endif
+
+	return decodeScalar( hex + done, count - done, out + done / 2 );
+}
+
+} // namespace Denom
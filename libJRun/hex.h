@@ -0,0 +1,40 @@
+/// Denom.org
+///
+/// MIT No Attribution.
+///
+/// Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software
+/// without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+/// permit persons to whom the Software is furnished to do so.
+///
+/// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+/// PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+/// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+///
+/// Author:  Sergey Novochenko,  Digrol@gmail.com
+///
+/// Fast conversion of bytes to HEX-characters and back.
+
+#ifndef HEX_H_5D93A1E07C6B4F28
+#define HEX_H_5D93A1E07C6B4F28
+
+#include <stdint.h>
+#include <stddef.h>
+
+namespace Denom {
+
+// ---------------------------------------------------------------------------------------------------------------------
+/// Convert 'size' bytes to 2 * 'size' HEX-characters without separators.
+/// Uses SSSE3 / AVX2 if CPU supports them.
+/// @param out - buffer for 2 * 'size' chars, terminating zero is not written.
+void hexEncode( const uint8_t* data, size_t size, char* out, bool upperCase );
+
+// ---------------------------------------------------------------------------------------------------------------------
+/// Convert 'count' HEX-characters without separators to 'count' / 2 bytes.
+/// Allowed symbols: 0..9, a..f, A..F.
+/// @param out - buffer for 'count' / 2 bytes.
+/// @return false if 'count' is odd or wrong symbol found.
+bool hexDecode( const char* hex, size_t count, uint8_t* out );
+
+} // namespace Denom
+
+#endif // Header guard
@@ -0,0 +1,178 @@
+/// Denom.org
+///
+/// MIT No Attribution.
+///
+/// Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software
+/// without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+/// permit persons to whom the Software is furnished to do so.
+///
+/// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+/// PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+/// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+///
+/// Author:  Sergey Novochenko,  Digrol@gmail.com
+///
+/// Latency histogram and scoped timer.
+
+#include "stdinc.h"
+
+#include "histogram.h"
+#include <cwchar>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace {
+
+// ---------------------------------------------------------------------------------------------------------------------
+/// Number of the highest set bit, 'value' != 0.
+uint32_t highestBit( uint64_t value )
+{
+	#ifdef _MSC_VER
+		unsigned long index;
+		_BitScanReverse64( &index, value );
+		return (uint32_t)index;
+	#else
+		return 63 - (uint32_t)__builtin_clzll( value );
+	#endif
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+/// Nanoseconds to short string: "850ns", "12.30us", "1.20ms", "2.51s".
+std::wstring formatNs( uint64_t ns )
+{
+	wchar_t buf[ 32 ];
+	if( ns < 1000 )
+		swprintf( buf, ARRAY_SIZE( buf ), L"%uns", (unsigned)ns );
+	else if( ns < 1000000 )
+		swprintf( buf, ARRAY_SIZE( buf ), L"%.2fus", ns / 1e3 );
+	else if( ns < 1000000000 )
+		swprintf( buf, ARRAY_SIZE( buf ), L"%.2fms", ns / 1e6 );
+	else
+		swprintf( buf, ARRAY_SIZE( buf ), L"%.2fs", ns / 1e9 );
+	return buf;
+}
+
+} // namespace
+
+namespace Denom {
+
+// ---------------------------------------------------------------------------------------------------------------------
+LatencyHistogram::LatencyHistogram()
+{
+	reset();
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+uint32_t LatencyHistogram::bucketIndex( uint64_t value )
+{
+	if( value < SUB_COUNT )
+	{
+		return (uint32_t)value;
+	}
+	uint32_t shift = highestBit( value ) - SUB_BITS;
+	return (shift + 1) * SUB_COUNT + (uint32_t)(value >> shift) - SUB_COUNT;
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+uint64_t LatencyHistogram::bucketHighest( uint32_t index )
+{
+	if( index < SUB_COUNT )
+	{
+		return index;
+	}
+	uint32_t shift = index / SUB_COUNT - 1;
+	uint64_t sub = index % SUB_COUNT + SUB_COUNT;
+	return ((sub + 1) << shift) - 1;
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+void LatencyHistogram::record( uint64_t value )
+{
+	buckets[ bucketIndex( value ) ].fetch_add( 1, std::memory_order_relaxed );
+	total.fetch_add( 1, std::memory_order_relaxed );
+	sum.fetch_add( value, std::memory_order_relaxed );
+
+	uint64_t cur = minValue.load( std::memory_order_relaxed );
+	while( (value < cur) && !minValue.compare_exchange_weak( cur, value, std::memory_order_relaxed ) )
+	{
+	}
+	cur = maxValue.load( std::memory_order_relaxed );
+	while( (value > cur) && !maxValue.compare_exchange_weak( cur, value, std::memory_order_relaxed ) )
+	{
+	}
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+void LatencyHistogram::reset()
+{
+	for( auto& bucket : buckets )
+	{
+		bucket.store( 0, std::memory_order_relaxed );
+	}
+	total.store( 0, std::memory_order_relaxed );
+	sum.store( 0, std::memory_order_relaxed );
+	minValue.store( UINT64_MAX, std::memory_order_relaxed );
+	maxValue.store( 0, std::memory_order_relaxed );
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+uint64_t LatencyHistogram::getCount() const
+{
+	return total.load( std::memory_order_relaxed );
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+uint64_t LatencyHistogram::getMin() const
+{
+	return getCount() ? minValue.load( std::memory_order_relaxed ) : 0;
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+uint64_t LatencyHistogram::getMax() const
+{
+	return maxValue.load( std::memory_order_relaxed );
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+uint64_t LatencyHistogram::getMean() const
+{
+	uint64_t n = getCount();
+	return n ? sum.load( std::memory_order_relaxed ) / n : 0;
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+uint64_t LatencyHistogram::percentile( double percent ) const
+{
+	uint64_t n = getCount();
+	if( n == 0 )
+	{
+		return 0;
+	}
+
+	// Rank of wanted value, 1..n
+	uint64_t rank = (uint64_t)(percent / 100.0 * (double)n + 0.5);
+	rank = (rank < 1) ? 1 : ((rank > n) ? n : rank);
+
+	uint64_t seen = 0;
+	for( uint32_t i = 0; i < BUCKET_COUNT; ++i )
+	{
+		seen += buckets[ i ].load( std::memory_order_relaxed );
+		if( seen >= rank )
+		{
+			// Exact extreme values are known
+			uint64_t value = bucketHighest( i );
+			return (value > getMax()) ? getMax() : ((value < getMin()) ? getMin() : value);
+		}
+	}
+	return getMax();
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+std::wstring LatencyHistogram::summary() const
+{
+	return L"count=" + std::to_wstring( getCount() ) + L" p50=" + formatNs( p50() ) + L" p99=" + formatNs( p99() ) +
+		L" max=" + formatNs( getMax() );
+}
+
+} // namespace Denom
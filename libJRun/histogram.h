@@ -0,0 +1,101 @@
+/// Denom.org
+///
+/// MIT No Attribution.
+///
+/// Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software
+/// without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+/// permit persons to whom the Software is furnished to do so.
+///
+/// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+/// PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+/// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+///
+/// Author:  Sergey Novochenko,  Digrol@gmail.com
+///
+/// Latency histogram and scoped timer.
+
+#ifndef HISTOGRAM_H_9F2B64D0E1A7C385
+#define HISTOGRAM_H_9F2B64D0E1A7C385
+
+#include <stdint.h>
+#include <stddef.h>
+#include <atomic>
+#include <string>
+#include "utils.h"
+
+namespace Denom {
+
+// ---------------------------------------------------------------------------------------------------------------------
+/// Log-linear histogram of values (usually nanoseconds): each power of 2 is divided into 32 linear sub-buckets,
+/// so relative error of percentiles is less than 3% in whole uint64_t range.
+/// Recording is lock-free (one relaxed atomic increment), values may be recorded from several threads.
+class LatencyHistogram
+{
+public:
+	LatencyHistogram();
+
+	LatencyHistogram( const LatencyHistogram& ) = delete;
+	LatencyHistogram& operator=( const LatencyHistogram& ) = delete;
+
+	// -----------------------------------------------------------------------------------------------------------------
+	void record( uint64_t value );
+
+	/// Forget all recorded values.
+	void reset();
+
+	// -----------------------------------------------------------------------------------------------------------------
+	uint64_t getCount() const;
+	uint64_t getMin() const;
+	uint64_t getMax() const;
+	uint64_t getMean() const;
+
+	/// Value, which is not less than 'percent' % of recorded values. 0 if histogram is empty.
+	/// @param percent - [0, 100].
+	uint64_t percentile( double percent ) const;
+
+	uint64_t p50() const { return percentile( 50 ); }
+	uint64_t p99() const { return percentile( 99 ); }
+
+	/// Example: "count=12 p50=1.20ms p99=3.51ms max=3.60ms", values are treated as nanoseconds.
+	std::wstring summary() const;
+
+private:
+	static const uint32_t SUB_BITS = 5;
+	static const uint32_t SUB_COUNT = 1 << SUB_BITS;
+	static const uint32_t BUCKET_COUNT = (64 - SUB_BITS + 1) * SUB_COUNT;
+
+	static uint32_t bucketIndex( uint64_t value );
+	static uint64_t bucketHighest( uint32_t index );
+
+	std::atomic<uint64_t> buckets[ BUCKET_COUNT ];
+	std::atomic<uint64_t> total;
+	std::atomic<uint64_t> sum;
+	std::atomic<uint64_t> minValue;
+	std::atomic<uint64_t> maxValue;
+};
+
+// ---------------------------------------------------------------------------------------------------------------------
+/// Records time of its life into histogram, in nanoseconds.
+/// Example:
+///     static LatencyHistogram compileTime;
+///     {
+///         ScopedTimer timer( compileTime );
+///         compile();
+///     }
+class ScopedTimer
+{
+public:
+	explicit ScopedTimer( LatencyHistogram& histogram, bool useTsc = false ) : hist( histogram ), ticker( useTsc ) {}
+	~ScopedTimer() { hist.record( (uint64_t)ticker.diffNs() ); }
+
+	ScopedTimer( const ScopedTimer& ) = delete;
+	ScopedTimer& operator=( const ScopedTimer& ) = delete;
+
+private:
+	LatencyHistogram& hist;
+	Ticker ticker;
+};
+
+} // namespace Denom
+
+#endif // Header guard
@@ -17,4 +17,103 @@
 #include "stdinc.h"
 
 #include "ihash.h"
+#include "mappedbinary.h"
+#include "trace.h"
 
+#ifndef _WIN32
+	#include <fcntl.h>
+	#include <unistd.h>
+#endif
+#include <sys/stat.h>
+#include <cerrno>
+
+using std::wstring;
+
+namespace Denom {
+
+// ---------------------------------------------------------------------------------------------------------------------
+void IHash::process( const Binary& data )
+{
+	process( data.data(), data.size() );
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+Binary IHash::calc( const Binary& data )
+{
+	return calc( data.data(), data.size() );
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+Binary IHash::calc( const uint8_t* data, size_t length )
+{
+	TraceSpan span( "IHash::calc" );
+	reset();
+	process( data, length );
+	return getHash();
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+/// Only regular file with known size can be mapped: pipes, FIFO and files in /proc report size 0.
+static bool isMappable( const NativeName& fileName )
+{
+	#ifdef _WIN32
+		struct _stat64 st;
+		return (_wstat64( fileName.c_str(), &st ) == 0) && ((st.st_mode & _S_IFMT) == _S_IFREG) && (st.st_size > 0);
+	#else
+		struct stat st;
+		return (stat( fileName.c_str(), &st ) == 0) && S_ISREG( st.st_mode ) && (st.st_size > 0);
+	#endif
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+Binary IHash::calcNativeFileHash( const NativeName& fileName )
+{
+	if( isMappable( fileName ) )
+	{
+		// Hash directly from page cache, without copying of file body
+		MappedBinary file( fileName );
+		return calc( file.data(), file.size() );
+	}
+
+	reset();
+	std::vector<uint8_t> buf( 0x10000 );
+	#ifdef _WIN32
+		FILE* f = _wfopen( fileName.c_str(), L"rb" );
+		MUST_M( f != NULL, L"Can't open file: " + fromNative( fileName ) );
+
+		size_t bytesRead = 0;
+		while( (bytesRead = fread( buf.data(), 1, buf.size(), f )) != 0 )
+			process( buf.data(), bytesRead );
+		bool isError = ferror( f ) != 0;
+		fclose( f );
+	#else
+		int fd = open( fileName.c_str(), O_RDONLY | O_CLOEXEC );
+		MUST_M( fd != -1, L"Can't open file: " + fromNative( fileName ) );
+
+		ssize_t bytesRead = 0;
+		while( ((bytesRead = read( fd, buf.data(), buf.size() )) > 0) || ((bytesRead == -1) && (errno == EINTR)) )
+		{
+			if( bytesRead > 0 )
+				process( buf.data(), (size_t)bytesRead );
+		}
+		bool isError = bytesRead != 0;
+		close( fd );
+	#endif
+
+	MUST_M( !isError, L"Error while hashing file " + fromNative( fileName ) );
+	return getHash();
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+Binary IHash::calcFileHash( const wstring& fileName )
+{
+	return calcNativeFileHash( toNative( fileName ) );
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+Binary IHash::calcFileHash( std::string_view fileName )
+{
+	return calcNativeFileHash( toNative( fileName ) );
+}
+
+} // namespace Denom
@@ -20,6 +20,7 @@
 #include <stdint.h>
 #include <string>
 #include "binary.h"
+#include "utils.h"
 
 namespace Denom
 {
@@ -28,188 +29,56 @@ namespace Denom
 /// Abstract cryptographic hash function.
 /// Processes binary data and produces 'hash' (another byte array).
 /// 1. Calculating hash in one step:
-///     Binary hash = new IHash().calc( data );
+///     Binary hash = Sha256().calc( data );
 /// 2. Calculating hash by parts, using 'reset', 'process', 'getHash':
-///     IHash alg = new IHash();
+///     Sha256 alg;
 ///     alg.process( part1 );
 ///     alg.process( partN );
 ///     Binary hash = alg.getHash();
 class IHash
 {
 public:
+	virtual ~IHash() {}
 
 	/// Virtual constructor of copies.
+	/// Creates new object of the same class without current state.
 	virtual IHash* clone() const = 0;
 
+	/// Creates new object of the same class WITH current state.
+	virtual IHash* cloneState() const = 0;
+
 	/// Returns size of hash.
 	virtual uint32_t getSize() const = 0;
 
 	/// Returns hash name.
 	virtual std::wstring getName() const = 0;
 
-	/// Calculates hash from data.
-//	virtual Binary Calc( const Binary& data ) = 0;
-};
-
-} // namespace Denom
-
-#endif // Header guard
-
-#if 0
-	// -----------------------------------------------------------------------------------------------------------------
-	final int blockSize;
-	Binary tail;
-	long processedBytes = 0;
-
-	// -----------------------------------------------------------------------------------------------------------------
-	protected IHash( int blockSize )
-	{
-		this.blockSize = blockSize;
-		this.tail = new Binary().reserve( blockSize );
-	}
-
-	// -----------------------------------------------------------------------------------------------------------------
-	/**
-	 * @return Size of producing hash in bytes.
-	 */
-	public abstract int size();
-
-	// -----------------------------------------------------------------------------------------------------------------
-	/**
-	 * @return Hashing algorithm name.
-	 */
-	public abstract String name();
-
 	// -----------------------------------------------------------------------------------------------------------------
-	/**
-	 * Calculate hash of data.
-	 */
-	public final Binary calc( final Binary data )
-	{
-		return calc( data, 0, data.size() );
-	}
+	/// Resets state of algorithm.
+	virtual void reset() = 0;
 
-	// -----------------------------------------------------------------------------------------------------------------
-	/**
-	 * Calculate hash of data.
-	 */
-	public final Binary calc( final Binary data, int offset, int len )
-	{
-		reset();
-		process( data, offset, len );
-		return getHash();
-	}
-
-	// -----------------------------------------------------------------------------------------------------------------
-	/**
-	 * Resets state of algorihtm.
-	 */
-	public void reset()
-	{
-		processedBytes = 0;
-		tail.clear();
-	}
-
-	// -----------------------------------------------------------------------------------------------------------------
-	public final void process( final Binary data )
-	{
-		process( data, 0, data.size() );
-	}
-
-	// -----------------------------------------------------------------------------------------------------------------
-	protected abstract void processBlock( Binary data, int offset );
+	/// Processes next part of data. Data is not buffered, except the tail of incomplete block.
+	virtual void process( const uint8_t* data, size_t length ) = 0;
 
-	// -----------------------------------------------------------------------------------------------------------------
-	public void process( final Binary data, int offset, int length )
-	{
-		if( length == 0 )
-			return;
-
-		processedBytes += length;
-
-		if( !tail.empty() )
-		{	// concatenate remainder with new data
-			int part1 = Math.min( blockSize - tail.size(), length );
-			tail.add( data.getDataRef(), offset, part1 );
-			offset += part1;
-			length -= part1;
-
-			if( tail.size() == blockSize )
-			{
-				processBlock( tail, 0 );
-				tail.clear();
-			}
-		}
-
-		for( ; length >= blockSize; offset += blockSize, length -= blockSize )
-		{
-			processBlock( data, offset );
-		}
-
-		if( length != 0 )
-		{	// save remainder
-			tail.assign( data, offset, length );
-		}
-	}
+	void process( const Binary& data );
 
-	// -----------------------------------------------------------------------------------------------------------------
-	/**
-	 * Convenience.
-	 * Calc hash of file body.
-	 */
-	public Binary calcFileHash( String fileName )
-	{
-		reset();
-
-		try(RandomAccessFile file = new RandomAccessFile( fileName, "r" ))
-		{
-			Binary buf = new Binary();
-			long size = file.length();
-			while( size > 0 )
-			{
-				buf.resize( 0x10000 );
-				int chunkSize = file.read( buf.getDataRef(), 0, buf.getDataRef().length );
-				MUST( chunkSize > 0, "Error while hashing file " + fileName );
-				buf.resize( chunkSize );
-				process( buf );
-				size -= chunkSize;
-			}
-		}
-		catch( IOException ex )
-		{
-			THROW( ex.toString() );
-		}
-		return getHash();
-	}
+	/// Returns hash of all processed data and resets state.
+	virtual Binary getHash() = 0;
 
 	// -----------------------------------------------------------------------------------------------------------------
-	/**
-	 * Resets state.
-	 * @return hash of all processed data.
-	 */
-	public abstract Binary getHash();
+	/// Calculates hash from data.
+	Binary calc( const Binary& data );
+	Binary calc( const uint8_t* data, size_t length );
 
-	// -----------------------------------------------------------------------------------------------------------------
-	@Override
-		/**
-		 * Create new object of same class without current state.
-		 */
-		public abstract IHash clone();
+	/// Calculates hash of file body. Regular file is mapped to memory (see MappedBinary) and must not be truncated
+	/// meanwhile; pipes and other special files are read by parts.
+	Binary calcFileHash( const std::wstring& fileName );
+	Binary calcFileHash( std::string_view fileName );
 
-	// -----------------------------------------------------------------------------------------------------------------
-	/**
-	 * Create new object of same class WITH current state.
-	 */
-	public abstract IHash cloneState();
+private:
+	Binary calcNativeFileHash( const NativeName& fileName );
+};
 
-	// -----------------------------------------------------------------------------------------------------------------
-	protected IHash cloneStateBase()
-	{
-		IHash cloned = this.clone();
-		MUST( cloned.blockSize == this.blockSize, "Wrong implementation of cloneState" );
-		cloned.tail = this.tail.clone();
-		cloned.processedBytes = this.processedBytes;
-		return cloned;
-	}
-#endif
+} // namespace Denom
 
+#endif // Header guard
@@ -14,7 +14,9 @@
 
 #include "stdinc.h"
 
-#include <cstdarg>
+#include "log.h"
+
+#include <cerrno>
 
 #ifdef _WIN32
 #include <windows.h>
@@ -24,104 +26,125 @@
 #include <unistd.h>
 #endif
 
-using std::vector;
 using std::string;
 using std::wstring;
 
 namespace Denom {
 
-// ---------------------------------------------------------------------------------------------------------------------
-wstring formatStr( const wchar_t* format, va_list args )
-{
-	vector<wchar_t> buf( 512 );
+/// ====================================================================================================================
+
+namespace Console {
+
+	// Output is collected in buffer of current thread and written by one system call:
+	// colors, text and new line together. Inside 'Batch' - by blocks up to BATCH_LIMIT bytes.
+	static const size_t BATCH_LIMIT = 64 * 1024;
+
+	static void flushBuffer( string& buf );
 
-	int len = 0;
-	do
+	struct OutBuffer
 	{
-		va_list argCopy;
-		va_copy( argCopy, args );
-		len = vswprintf( &buf[ 0 ], buf.size(), format, argCopy );
-		va_end( argCopy );
+		string data;
+		string utf8;  // reusable buffer for conversion of wide text
+		string formatted;
+		int batchDepth = 0;
 
-		if( len < 0 )
-		{
-			buf.resize( buf.size() * 2 );
-		}
-		else if( len >= buf.size() )
+		~OutBuffer()
 		{
-			buf.resize( (size_t)(len + 1) );
-			len = -1;
+			flushBuffer( data );
 		}
-	}
-	while( len < 0 );
+	};
 
-	return wstring( &buf[ 0 ], &buf[ 0 ] + len );
-}
+	static thread_local OutBuffer out;
 
-// ---------------------------------------------------------------------------------------------------------------------
-wstring formatStr( const wchar_t* format, ... )
-{
-	va_list args;
-	va_start( args, format );
-	wstring result = formatStr( format, args );
-	va_end( args );
-	return result;
-}
+	// ---------------------------------------------------------------------------------------------------------------------
+	static void writeOut( const char* p, size_t size )
+	{
+		#ifdef _WIN32
+			static bool cpSet = SetConsoleOutputCP( CP_UTF8 ) != FALSE;
+			(void)cpSet;
+			_write( _fileno( stdout ), p, (unsigned int)size );
+		#else
+			while( size != 0 )
+			{
+				ssize_t written = write( STDOUT_FILENO, p, size );
+				if( written < 0 )
+				{
+					if( errno == EINTR )
+						continue;
+					return;
+				}
+				p += written;
+				size -= (size_t)written;
+			}
+		#endif
+	}
 
-/// ====================================================================================================================
+	// ---------------------------------------------------------------------------------------------------------------------
+	static void flushBuffer( string& buf )
+	{
+		if( !buf.empty() )
+		{
+			writeOut( buf.data(), buf.size() );
+			buf.clear();
+		}
+	}
 
-namespace Console {
+	// ---------------------------------------------------------------------------------------------------------------------
+	/// Called after each print: outside of Batch buffer is written at once.
+	static void commit()
+	{
+		if( (out.batchDepth == 0) || (out.data.size() >= BATCH_LIMIT) )
+			flushBuffer( out.data );
+	}
 
-	static void printImpl( const char* utf8StrPtr, unsigned int strSize )
+	// ---------------------------------------------------------------------------------------------------------------------
+	bool isTerminal()
 	{
 		#ifdef _WIN32
-			SetConsoleOutputCP( CP_UTF8 );
-			_write( _fileno( stdout ), utf8StrPtr, strSize );
+			static const bool terminal = _isatty( _fileno( stdout ) ) != 0;
 		#else
-			write( STDOUT_FILENO, utf8StrPtr, strSize );
+			static const bool terminal = isatty( STDOUT_FILENO ) != 0;
 		#endif
+		return terminal;
 	}
 
 	// ---------------------------------------------------------------------------------------------------------------------
-	static void printImpl( uint32_t color, const char* utf8StrPtr, unsigned int strSize )
-	{
-		static string colorReset = "\033[0m";
-		static string strTextColors[ 16 ] = {
-			"\033[30m", // BLACK       [  0 ]
-			"\033[34m", // BLUE        [  1 ]
-			"\033[32m", // GREEN       [  2 ]
-			"\033[36m", // CYAN        [  3 ]
-			"\033[31m", // RED         [  4 ]
-			"\033[35m", // MAGENTA     [  5 ]
-			"\033[33m", // YELLOW      [  6 ]
-			"\033[37m", // GRAY        [  7 ]
-			"\033[90m", // BLACK_I     [  8 ]
-			"\033[94m", // BLUE_I      [  9 ]
-			"\033[92m", // GREEN_I     [ 10 ]
-			"\033[96m", // CYAN_I      [ 11 ]
-			"\033[91m", // RED_I       [ 12 ]
-			"\033[95m", // MAGENTA_I   [ 13 ]
-			"\033[93m", // YELLOW_I    [ 14 ]
-			"\033[97m"  // GRAY_I      [ 15 ]
-		};
-		static string strBgColors[ 16 ] = {
-			"\033[40m", // BLACK       [  0 ]
-			"\033[44m", // BLUE        [  1 ]
-			"\033[42m", // GREEN       [  2 ]
-			"\033[46m", // CYAN        [  3 ]
-			"\033[41m", // RED         [  4 ]
-			"\033[45m", // MAGENTA     [  5 ]
-			"\033[43m", // YELLOW      [  6 ]
-			"\033[47m", // GRAY        [  7 ]
-			"\033[100m", // BLACK_I     [  8 ]
-			"\033[104m", // BLUE_I      [  9 ]
-			"\033[102m", // GREEN_I     [ 10 ]
-			"\033[106m", // CYAN_I      [ 11 ]
-			"\033[101m", // RED_I       [ 12 ]
-			"\033[105m", // MAGENTA_I   [ 13 ]
-			"\033[103m", // YELLOW_I    [ 14 ]
-			"\033[107m"  // GRAY_I      [ 15 ]
-		};
+	void flush()
+	{
+		flushBuffer( out.data );
+	}
+
+	// ---------------------------------------------------------------------------------------------------------------------
+	Batch::Batch()
+	{
+		++out.batchDepth;
+	}
+
+	// ---------------------------------------------------------------------------------------------------------------------
+	Batch::~Batch()
+	{
+		if( --out.batchDepth == 0 )
+			flushBuffer( out.data );
+	}
+
+	// ---------------------------------------------------------------------------------------------------------------------
+	static void printImpl( const char* utf8StrPtr, size_t strSize, bool newLine )
+	{
+		out.data.append( utf8StrPtr, strSize );
+		if( newLine )
+			out.data += '\n';
+		commit();
+	}
+
+	// ---------------------------------------------------------------------------------------------------------------------
+	static void printImpl( uint32_t color, const char* utf8StrPtr, size_t strSize, bool newLine )
+	{
+		if( !isTerminal() )
+		{
+			// Escape codes only spoil output, redirected to file or pipe
+			printImpl( utf8StrPtr, strSize, newLine );
+			return;
+		}
 
 		#ifdef _WIN32
 			static HANDLE h = ::GetStdHandle( STD_OUTPUT_HANDLE );
@@ -135,100 +158,129 @@ namespace Console {
 				consoleAttr = info.wAttributes;
 			}
 
+			// Attributes are applied to text, already written to console
+			flushBuffer( out.data );
 			SetConsoleTextAttribute( h, (WORD)color );
-			printImpl( utf8StrPtr, strSize );
+			writeOut( utf8StrPtr, strSize );
 			SetConsoleTextAttribute( h, consoleAttr );
+			if( newLine )
+				out.data += '\n';
 		#else
-			printImpl( strTextColors[ color & 0x0F ].c_str(), strTextColors[ color & 0x0F ].size() );
+			static const char* const strTextColors[ 16 ] = {
+				"\033[30m", // BLACK       [  0 ]
+				"\033[34m", // BLUE        [  1 ]
+				"\033[32m", // GREEN       [  2 ]
+				"\033[36m", // CYAN        [  3 ]
+				"\033[31m", // RED         [  4 ]
+				"\033[35m", // MAGENTA     [  5 ]
+				"\033[33m", // YELLOW      [  6 ]
+				"\033[37m", // GRAY        [  7 ]
+				"\033[90m", // BLACK_I     [  8 ]
+				"\033[94m", // BLUE_I      [  9 ]
+				"\033[92m", // GREEN_I     [ 10 ]
+				"\033[96m", // CYAN_I      [ 11 ]
+				"\033[91m", // RED_I       [ 12 ]
+				"\033[95m", // MAGENTA_I   [ 13 ]
+				"\033[93m", // YELLOW_I    [ 14 ]
+				"\033[97m"  // GRAY_I      [ 15 ]
+			};
+			static const char* const strBgColors[ 16 ] = {
+				"\033[40m", // BLACK       [  0 ]
+				"\033[44m", // BLUE        [  1 ]
+				"\033[42m", // GREEN       [  2 ]
+				"\033[46m", // CYAN        [  3 ]
+				"\033[41m", // RED         [  4 ]
+				"\033[45m", // MAGENTA     [  5 ]
+				"\033[43m", // YELLOW      [  6 ]
+				"\033[47m", // GRAY        [  7 ]
+				"\033[100m", // BLACK_I     [  8 ]
+				"\033[104m", // BLUE_I      [  9 ]
+				"\033[102m", // GREEN_I     [ 10 ]
+				"\033[106m", // CYAN_I      [ 11 ]
+				"\033[101m", // RED_I       [ 12 ]
+				"\033[105m", // MAGENTA_I   [ 13 ]
+				"\033[103m", // YELLOW_I    [ 14 ]
+				"\033[107m"  // GRAY_I      [ 15 ]
+			};
+
+			out.data += strTextColors[ color & 0x0F ];
 			int bgIndex = (color >> 4) & 0x0F;
 			if( bgIndex != 0 )
-				printImpl( strBgColors[ bgIndex ].c_str(), strBgColors[ bgIndex ].size() );
-			printImpl( utf8StrPtr, strSize );
-			printImpl( colorReset.c_str(), colorReset.size() );
+				out.data += strBgColors[ bgIndex ];
+			out.data.append( utf8StrPtr, strSize );
+			out.data += "\033[0m";
+			if( newLine )
+				out.data += '\n';
 		#endif
+
+		commit();
 	}
 
 	// ---------------------------------------------------------------------------------------------------------------------
-	void print( const string& utf8Str )
+	/// Wide text -> UTF-8 in reusable buffer of current thread.
+	static const string& toUtf8( const wstring& text )
 	{
-		printImpl( utf8Str.c_str(), (unsigned int)utf8Str.size() );
+		w2s( text, out.utf8 );
+		return out.utf8;
 	}
 
 	// ---------------------------------------------------------------------------------------------------------------------
-	void println( const std::string& utf8Str )
+	string& formatBuffer()
 	{
-		printImpl( utf8Str.c_str(), (unsigned int)utf8Str.size() );
-		printImpl( u8"\n", 1 );
+		out.formatted.clear();
+		return out.formatted;
 	}
 
 	// ---------------------------------------------------------------------------------------------------------------------
-	void print( const std::wstring& text )
+	void print( const string& utf8Str )
 	{
-		print( w2s(text) );
+		printImpl( utf8Str.c_str(), utf8Str.size(), false );
 	}
 
 	// ---------------------------------------------------------------------------------------------------------------------
-	void println( const std::wstring& text )
+	void println( const std::string& utf8Str )
 	{
-		print( w2s( text ) );
-		printImpl( u8"\n", 1 );
+		printImpl( utf8Str.c_str(), utf8Str.size(), true );
 	}
 
 	// ---------------------------------------------------------------------------------------------------------------------
-	void print( const wchar_t* str, ... )
+	void print( const std::wstring& text )
 	{
-		va_list args;
-		va_start( args, str );
-		wstring ws = formatStr( str, args );
-		va_end( args );
-		print( ws );
+		const string& s = toUtf8( text );
+		printImpl( s.c_str(), s.size(), false );
 	}
 
 	// ---------------------------------------------------------------------------------------------------------------------
-	void println( const wchar_t* text, ... )
+	void println( const std::wstring& text )
 	{
-		va_list args;
-		va_start( args, text );
-		wstring ws = formatStr( text, args );
-		va_end( args );
-		print( ws );
-		printImpl( u8"\n", 1 );
+		const string& s = toUtf8( text );
+		printImpl( s.c_str(), s.size(), true );
 	}
 
 	// ---------------------------------------------------------------------------------------------------------------------
-	void print( uint32_t color, const std::wstring& text )
+	void print( uint32_t color, const std::string& utf8Str )
 	{
-		string s = w2s( text );
-		printImpl( color, s.c_str(), (unsigned int)s.size() );
+		printImpl( color, utf8Str.c_str(), utf8Str.size(), false );
 	}
 
 	// ---------------------------------------------------------------------------------------------------------------------
-	void println( uint32_t color, const std::wstring& text )
+	void println( uint32_t color, const std::string& utf8Str )
 	{
-		string s = w2s( text );
-		printImpl( color, s.c_str(), (unsigned int)s.size() );
-		printImpl( u8"\n", 1 );
+		printImpl( color, utf8Str.c_str(), utf8Str.size(), true );
 	}
 
 	// ---------------------------------------------------------------------------------------------------------------------
-	void print( uint32_t color, const wchar_t* text, ... )
+	void print( uint32_t color, const std::wstring& text )
 	{
-		va_list args;
-		va_start( args, text );
-		wstring ws = formatStr( text, args );
-		va_end( args );
-		print( color, ws );
+		const string& s = toUtf8( text );
+		printImpl( color, s.c_str(), s.size(), false );
 	}
 
 	// ---------------------------------------------------------------------------------------------------------------------
-	void println( uint32_t color, const wchar_t* text, ... )
+	void println( uint32_t color, const std::wstring& text )
 	{
-		va_list args;
-		va_start( args, text );
-		wstring ws = formatStr( text, args );
-		va_end( args );
-		print( color, ws );
-		printImpl( u8"\n", 1 );
+		const string& s = toUtf8( text );
+		printImpl( color, s.c_str(), s.size(), true );
 	}
 
 } // namespace Console
@@ -16,12 +16,10 @@
 
 #include <string>
 #include <memory>
+#include "format.h"
 
 namespace Denom {
 
-std::wstring formatStr( const wchar_t* format, ... );
-std::wstring formatStr( const wchar_t* format, va_list a );
-
 // =====================================================================================================================
 /// Text Colors
 // =====================================================================================================================
@@ -67,22 +65,78 @@ const uint32_t COLOR_ERROR = COLOR_RED_I;
 // =====================================================================================================================
 namespace Console
 {
+	/// Each print is written to stdout by one system call: colors, text and new line together.
+	/// Colors are printed only if stdout is terminal (not file or pipe).
+
+	/// Output of current thread is collected while Batch object exists, and written by large blocks:
+	/// when 64 KB are collected, on 'flush' and when the outermost Batch is destroyed.
+	/// Example: printing of compiler diagnostics line by line.
+	class Batch
+	{
+	public:
+		Batch();
+		~Batch();
+
+		Batch( const Batch& ) = delete;
+		Batch& operator=( const Batch& ) = delete;
+	};
+
+	/// Write output, collected in Batch of current thread.
+	void flush();
+
+	/// true, if stdout is terminal.
+	bool isTerminal();
+
 	void print( const std::string& utf8Str );
 	void println( const std::string& utf8Str );
 
 	void print( const std::wstring& str );
 	void println( const std::wstring& text );
 
-	void print( const wchar_t* str, ... );
-	void println( const wchar_t* text, ... );
-
 	/// @param color - see constants COLOR_*. Symbol colors and BackGround colors can be combined.
 	/// Example: COLOR_BG_WHITE | COLOR_RED
+	void print( uint32_t color, const std::string& utf8Str );
+	void println( uint32_t color, const std::string& utf8Str );
+
 	void print( uint32_t color, const std::wstring& text );
 	void println( uint32_t color, const std::wstring& text );
 
-	void print( uint32_t color, const wchar_t* text, ... );
-	void println( uint32_t color, const wchar_t* text, ... );
+	/// Empty reusable buffer of current thread for formatting.
+	std::string& formatBuffer();
+
+	/// Formatted output, see FMT.
+	/// Example: Console::println( COLOR_ERROR, FMT( "Error: {}" ), ex.what() );
+	template< typename Literal, typename... Args, EnableIfFormat<Literal> = 0 >
+	void print( Literal format, const Args&... args )
+	{
+		std::string& buf = formatBuffer();
+		formatTo( buf, format, args... );
+		print( buf );
+	}
+
+	template< typename Literal, typename... Args, EnableIfFormat<Literal> = 0 >
+	void println( Literal format, const Args&... args )
+	{
+		std::string& buf = formatBuffer();
+		formatTo( buf, format, args... );
+		println( buf );
+	}
+
+	template< typename Literal, typename... Args, EnableIfFormat<Literal> = 0 >
+	void print( uint32_t color, Literal format, const Args&... args )
+	{
+		std::string& buf = formatBuffer();
+		formatTo( buf, format, args... );
+		print( color, buf );
+	}
+
+	template< typename Literal, typename... Args, EnableIfFormat<Literal> = 0 >
+	void println( uint32_t color, Literal format, const Args&... args )
+	{
+		std::string& buf = formatBuffer();
+		formatTo( buf, format, args... );
+		println( color, buf );
+	}
 }
 
 } // namespace Denom
@@ -0,0 +1,419 @@
+/// Denom.org
+///
+/// MIT No Attribution.
+///
+/// Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software
+/// without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+/// permit persons to whom the Software is furnished to do so.
+///
+/// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+/// PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+/// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+///
+/// Author:  Sergey Novochenko,  Digrol@gmail.com
+///
+/// Asynchronous logger.
+
+#include "stdinc.h"
+
+#include "logger.h"
+#include "utf8.h"
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <ctime>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <cerrno>
+
+#ifdef _WIN32
+#include <io.h>
+#include <fcntl.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+using Denom::LogEntry;
+using Denom::LogLevel;
+
+const size_t RING_SIZE = 4096; // power of 2
+
+// ---------------------------------------------------------------------------------------------------------------------
+/// Ring of entries, bounded MPMC queue by D. Vyukov, used with one consumer.
+/// 'sequence' of slot: == position - free for producer, == position + 1 - ready for consumer.
+struct Ring
+{
+	std::unique_ptr<LogEntry[]> slots;
+	alignas( 64 ) std::atomic<uint64_t> enqueuePos{ 0 };
+	alignas( 64 ) uint64_t dequeuePos = 0; // only writer thread
+
+	Ring() : slots( new LogEntry[ RING_SIZE ] )
+	{
+		for( size_t i = 0; i < RING_SIZE; ++i )
+			slots[ i ].sequence.store( i, std::memory_order_relaxed );
+	}
+
+	// -----------------------------------------------------------------------------------------------------------------
+	/// Waits if ring is full.
+	LogEntry* reserve()
+	{
+		uint64_t pos = enqueuePos.load( std::memory_order_relaxed );
+		for( ;; )
+		{
+			LogEntry& slot = slots[ pos & (RING_SIZE - 1) ];
+			int64_t diff = (int64_t)slot.sequence.load( std::memory_order_acquire ) - (int64_t)pos;
+			if( diff == 0 )
+			{
+				if( enqueuePos.compare_exchange_weak( pos, pos + 1, std::memory_order_relaxed ) )
+				{
+					slot.position = pos;
+					return &slot;
+				}
+			}
+			else
+			{
+				if( diff < 0 )
+					std::this_thread::yield();
+				pos = enqueuePos.load( std::memory_order_relaxed );
+			}
+		}
+	}
+
+	// -----------------------------------------------------------------------------------------------------------------
+	void publish( LogEntry* entry )
+	{
+		entry->sequence.store( entry->position + 1, std::memory_order_release );
+	}
+
+	// -----------------------------------------------------------------------------------------------------------------
+	/// @return next ready entry or nullptr.
+	LogEntry* peek()
+	{
+		LogEntry& slot = slots[ dequeuePos & (RING_SIZE - 1) ];
+		return (slot.sequence.load( std::memory_order_acquire ) == dequeuePos + 1) ? &slot : nullptr;
+	}
+
+	void release( LogEntry* entry )
+	{
+		entry->sequence.store( dequeuePos + RING_SIZE, std::memory_order_release );
+		++dequeuePos;
+	}
+};
+
+// ---------------------------------------------------------------------------------------------------------------------
+Denom::FormatArg toFormatArg( const LogEntry& e, size_t index )
+{
+	using Denom::FormatArg;
+	uint64_t v = e.values[ index ];
+	switch( e.types[ index ] )
+	{
+	case LogEntry::ARG_INT:
+		return FormatArg( (int64_t)v );
+	case LogEntry::ARG_UINT:
+		return FormatArg( v );
+	case LogEntry::ARG_DOUBLE:
+	{
+		double d;
+		memcpy( &d, &v, 8 );
+		return FormatArg( d );
+	}
+	case LogEntry::ARG_BOOL:
+		return FormatArg( v != 0 );
+	case LogEntry::ARG_CHAR:
+		return FormatArg( (char)v );
+	case LogEntry::ARG_TEXT:
+		return FormatArg( std::string_view( e.text + (v >> 16), (size_t)(v & 0xFFFF) ) );
+	case LogEntry::ARG_POINTER:
+		return FormatArg( (const void*)(uintptr_t)v );
+	}
+	return FormatArg();
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+/// "12:30:05.123 W message\n"
+void formatEntry( std::string& out, const LogEntry& e )
+{
+	static const char levelChars[] = "DIWE";
+
+	time_t sec = (time_t)(e.timeNs / 1000000000);
+	struct tm t;
+	#ifdef _WIN32
+		localtime_s( &t, &sec );
+	#else
+		localtime_r( &sec, &t );
+	#endif
+	char head[ 32 ];
+	int len = snprintf( head, sizeof( head ), "%02d:%02d:%02d.%03d %c ", t.tm_hour, t.tm_min, t.tm_sec,
+		(int)((e.timeNs / 1000000) % 1000), levelChars[ (int)e.level & 3 ] );
+	out.append( head, (size_t)len );
+
+	Denom::FormatArg args[ LogEntry::MAX_ARGS ];
+	for( size_t i = 0; i < e.argCount; ++i )
+		args[ i ] = toFormatArg( e, i );
+	Denom::vformatTo( out, e.format, args, e.argCount );
+	out += '\n';
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+void writeAll( int fd, const char* p, size_t size )
+{
+	while( size != 0 )
+	{
+		#ifdef _WIN32
+			int written = _write( fd, p, (unsigned int)size );
+		#else
+			ssize_t written = ::write( fd, p, size );
+			if( (written < 0) && (errno == EINTR) )
+				continue;
+		#endif
+		if( written <= 0 )
+			return;
+		p += written;
+		size -= (size_t)written;
+	}
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+class Writer
+{
+public:
+	~Writer()
+	{
+		stop();
+	}
+
+	// -----------------------------------------------------------------------------------------------------------------
+	void start()
+	{
+		if( active.load( std::memory_order_acquire ) )
+			return;
+
+		std::lock_guard<std::mutex> lock( mutex );
+		if( !running )
+		{
+			running = true;
+			thread = std::thread( &Writer::run, this );
+			active.store( true, std::memory_order_release );
+		}
+	}
+
+	// -----------------------------------------------------------------------------------------------------------------
+	void stop()
+	{
+		{
+			std::lock_guard<std::mutex> lock( mutex );
+			if( !running )
+				return;
+			running = false;
+			active.store( false, std::memory_order_release );
+		}
+		wake.notify_one();
+		thread.join();
+	}
+
+	// -----------------------------------------------------------------------------------------------------------------
+	void setOutput( int newFd )
+	{
+		flush();
+		std::lock_guard<std::mutex> lock( outputMutex );
+		if( ownFd )
+		{
+			#ifdef _WIN32
+				_close( fd );
+			#else
+				::close( fd );
+			#endif
+		}
+		ownFd = (newFd != stdoutFd());
+		fd = newFd;
+	}
+
+	// -----------------------------------------------------------------------------------------------------------------
+	void flush()
+	{
+		uint64_t target = ring.enqueuePos.load( std::memory_order_acquire );
+		std::unique_lock<std::mutex> lock( mutex );
+		if( !running )
+			return;
+		flushTarget = std::max( flushTarget, target );
+		wake.notify_one();
+		done.wait( lock, [&]{ return (written >= target) || !running; } );
+	}
+
+	// -----------------------------------------------------------------------------------------------------------------
+	/// Producers wake writer only if it sleeps, busy writer costs them no lock and no system call.
+	/// Pairs with 'run': either writer sees published entry, or producer sees 'sleeping'.
+	void notifyIfSleeping()
+	{
+		std::atomic_thread_fence( std::memory_order_seq_cst );
+		if( sleeping.load( std::memory_order_relaxed ) )
+		{
+			// Writer holds mutex from setting 'sleeping' till wait, so notify can't be lost
+			std::lock_guard<std::mutex> lock( mutex );
+			wake.notify_one();
+		}
+	}
+
+	static int stdoutFd()
+	{
+		#ifdef _WIN32
+			return _fileno( stdout );
+		#else
+			return STDOUT_FILENO;
+		#endif
+	}
+
+	Ring ring;
+
+private:
+	static const size_t BATCH_LIMIT = 64 * 1024;
+
+	// -----------------------------------------------------------------------------------------------------------------
+	void run()
+	{
+		std::string batch;
+		for( ;; )
+		{
+			LogEntry* entry;
+			while( (entry = ring.peek()) != nullptr )
+			{
+				formatEntry( batch, *entry );
+				ring.release( entry );
+				if( batch.size() >= BATCH_LIMIT )
+					writeBatch( batch );
+			}
+			writeBatch( batch );
+
+			std::unique_lock<std::mutex> lock( mutex );
+			written = ring.dequeuePos;
+			done.notify_all();
+			if( !running && (ring.peek() == nullptr) )
+				break;
+			if( (flushTarget > written) || (ring.peek() != nullptr) )
+				continue;
+
+			sleeping.store( true, std::memory_order_relaxed );
+			std::atomic_thread_fence( std::memory_order_seq_cst );
+			if( ring.peek() == nullptr )
+				wake.wait( lock );
+			sleeping.store( false, std::memory_order_relaxed );
+		}
+	}
+
+	// -----------------------------------------------------------------------------------------------------------------
+	void writeBatch( std::string& batch )
+	{
+		if( !batch.empty() )
+		{
+			std::lock_guard<std::mutex> lock( outputMutex );
+			writeAll( fd, batch.data(), batch.size() );
+			batch.clear();
+		}
+	}
+
+	std::mutex mutex;
+	std::mutex outputMutex; // 'fd' is changed while writer thread works
+	std::condition_variable wake;
+	std::condition_variable done;
+	std::thread thread;
+	bool running = false;
+	std::atomic<bool> active{ false }; // == running, for check without lock
+	uint64_t written = 0;     // entries, written to output
+	uint64_t flushTarget = 0;
+	std::atomic<bool> sleeping{ false };
+	int fd = stdoutFd();
+	bool ownFd = false;
+};
+
+// ---------------------------------------------------------------------------------------------------------------------
+Writer& writer()
+{
+	static Writer instance;
+	return instance;
+}
+
+} // namespace
+
+namespace Denom {
+
+std::atomic<uint8_t> Log::minLevel( (uint8_t)LogLevel::Info );
+
+// ---------------------------------------------------------------------------------------------------------------------
+void LogEntry::addText( const char* str, size_t len )
+{
+	len = std::min( len, TEXT_SIZE - textUsed );
+	memcpy( text + textUsed, str, len );
+	add( ARG_TEXT, ((uint64_t)textUsed << 16) | len );
+	textUsed = (uint16_t)(textUsed + len);
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+void LogEntry::addText( const wchar_t* str, size_t len )
+{
+	thread_local std::string utf8;
+	wideToUtf8( str, len, utf8 );
+	addText( utf8.data(), utf8.size() );
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+void Log::open( const std::string& filename )
+{
+	int fd = Writer::stdoutFd();
+	if( !filename.empty() )
+	{
+		#ifdef _WIN32
+			fd = _wopen( toNative( filename ).c_str(), _O_WRONLY | _O_CREAT | _O_APPEND | _O_BINARY, 0666 );
+		#else
+			fd = ::open( filename.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0666 );
+		#endif
+		MUST_M( fd != -1, L"Can't open log file: " + s2w( filename ) );
+	}
+	writer().setOutput( fd );
+	writer().start();
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+void Log::close()
+{
+	writer().stop();
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+void Log::flush()
+{
+	writer().flush();
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+void Log::setLevel( LogLevel level )
+{
+	minLevel.store( (uint8_t)level, std::memory_order_relaxed );
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+LogEntry* Log::beginEntry( LogLevel level, const char* format )
+{
+	writer().start();
+
+	LogEntry* entry = writer().ring.reserve();
+	entry->format = format;
+	entry->timeNs = std::chrono::duration_cast<std::chrono::nanoseconds>(
+		std::chrono::system_clock::now().time_since_epoch() ).count();
+	entry->level = level;
+	entry->argCount = 0;
+	entry->textUsed = 0;
+	return entry;
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+void Log::commitEntry( LogEntry* entry )
+{
+	writer().ring.publish( entry );
+	writer().notifyIfSleeping();
+}
+
+} // namespace Denom
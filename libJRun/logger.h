@@ -0,0 +1,175 @@
+/// Denom.org
+///
+/// MIT No Attribution.
+///
+/// Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software
+/// without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+/// permit persons to whom the Software is furnished to do so.
+///
+/// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+/// PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+/// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+///
+/// Author:  Sergey Novochenko,  Digrol@gmail.com
+///
+/// Asynchronous logger.
+
+#ifndef LOGGER_H_0E8C3B6A52F4D917
+#define LOGGER_H_0E8C3B6A52F4D917
+
+#include <stdint.h>
+#include <stddef.h>
+#include <atomic>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include "format.h"
+
+// ---------------------------------------------------------------------------------------------------------------------
+/// Messages with level below DENOM_LOG_MIN_LEVEL are removed by compiler, their arguments are not evaluated.
+/// 0 - Debug, 1 - Info, 2 - Warning, 3 - Error.
+#ifndef DENOM_LOG_MIN_LEVEL
+	#ifdef NDEBUG
+		#define DENOM_LOG_MIN_LEVEL 1
+	#else
+		#define DENOM_LOG_MIN_LEVEL 0
+	#endif
+#endif
+
+/// Format - string literal in UTF-8, see FMT. It is checked against arguments at compile time.
+/// Example:  LOGI( "Compiled {} in {} ms", fileName, ms );
+#define DENOM_LOG( level, format, ... ) \
+	do { \
+		if constexpr( Denom::isLogLevelCompiled( (int)(level) ) ) \
+			if( Denom::Log::isEnabled( level ) ) \
+				Denom::Log::write( level, FMT( format ), ##__VA_ARGS__ ); \
+	} while( 0 )
+
+#define LOGD( format, ... ) DENOM_LOG( Denom::LogLevel::Debug, format, ##__VA_ARGS__ )
+#define LOGI( format, ... ) DENOM_LOG( Denom::LogLevel::Info, format, ##__VA_ARGS__ )
+#define LOGW( format, ... ) DENOM_LOG( Denom::LogLevel::Warning, format, ##__VA_ARGS__ )
+#define LOGE( format, ... ) DENOM_LOG( Denom::LogLevel::Error, format, ##__VA_ARGS__ )
+
+namespace Denom {
+
+enum class LogLevel : uint8_t
+{
+	Debug = 0,
+	Info = 1,
+	Warning = 2,
+	Error = 3,
+	Off = 4
+};
+
+/// For DENOM_LOG: comparison of constants in macro gives "always true" warning, when DENOM_LOG_MIN_LEVEL is 0.
+constexpr bool isLogLevelCompiled( int level )
+{
+	return level >= DENOM_LOG_MIN_LEVEL;
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+/// Message, waiting in queue. Arguments are captured by value, strings are copied to 'text' (truncated if too long).
+/// Formatting is done later by writer thread.
+struct LogEntry
+{
+	static const size_t MAX_ARGS = 8;
+	static const size_t TEXT_SIZE = 144;
+
+	enum ArgType : uint8_t { ARG_INT, ARG_UINT, ARG_DOUBLE, ARG_BOOL, ARG_CHAR, ARG_TEXT, ARG_POINTER };
+
+	std::atomic<uint64_t> sequence; // state of slot in ring
+	uint64_t position;
+	const char* format;
+	int64_t timeNs;
+	LogLevel level;
+	uint8_t argCount;
+	uint16_t textUsed;
+	ArgType types[ MAX_ARGS ];
+	uint64_t values[ MAX_ARGS ]; // for ARG_TEXT: offset in 'text' << 16 | length
+	char text[ TEXT_SIZE ];
+
+	// -----------------------------------------------------------------------------------------------------------------
+	void add( ArgType type, uint64_t value )
+	{
+		types[ argCount ] = type;
+		values[ argCount ] = value;
+		++argCount;
+	}
+
+	void addText( const char* str, size_t len );
+	void addText( const wchar_t* str, size_t len );
+
+	// -----------------------------------------------------------------------------------------------------------------
+	void capture( bool v ) { add( ARG_BOOL, v ); }
+	void capture( char v ) { add( ARG_CHAR, (uint8_t)v ); }
+	void capture( double v ) { uint64_t bits; memcpy( &bits, &v, 8 ); add( ARG_DOUBLE, bits ); }
+	void capture( float v ) { capture( (double)v ); }
+	void capture( const char* v ) { addText( v, v ? strlen( v ) : 0 ); }
+	void capture( const std::string& v ) { addText( v.data(), v.size() ); }
+	void capture( std::string_view v ) { addText( v.data(), v.size() ); }
+	void capture( const wchar_t* v ) { addText( v, v ? wcslen( v ) : 0 ); }
+	void capture( const std::wstring& v ) { addText( v.data(), v.size() ); }
+	void capture( const void* v ) { add( ARG_POINTER, (uint64_t)(uintptr_t)v ); }
+
+	template< typename T, typename std::enable_if< std::is_integral<T>::value, int >::type = 0 >
+	void capture( T v )
+	{
+		if( std::is_signed<T>::value )
+			add( ARG_INT, (uint64_t)(int64_t)v );
+		else
+			add( ARG_UINT, (uint64_t)v );
+	}
+};
+
+// ---------------------------------------------------------------------------------------------------------------------
+/// Logging off the hot path: caller only copies arguments into lock-free ring (many producers, one consumer),
+/// background thread formats messages and writes them by batches to stdout or to file.
+/// If ring is full, caller waits for free slot - messages are not lost.
+/// Writer thread is started by first message; output - stdout, until 'open' is called.
+/// Usually used through macros LOGD, LOGI, LOGW, LOGE.
+class Log
+{
+public:
+	/// Write log to file (appended). Empty 'filename' - stdout.
+	static void open( const std::string& filename = std::string() );
+
+	/// Write all queued messages and stop writer thread. Logging after 'close' starts it again.
+	static void close();
+
+	/// Wait until all messages, logged before this call, are written.
+	static void flush();
+
+	// -----------------------------------------------------------------------------------------------------------------
+	/// Runtime threshold, messages with lower levels are skipped. Default - Info.
+	static void setLevel( LogLevel level );
+
+	static bool isEnabled( LogLevel level )
+	{
+		return (uint8_t)level >= minLevel.load( std::memory_order_relaxed );
+	}
+
+	// -----------------------------------------------------------------------------------------------------------------
+	/// @param format - created by FMT, literal is used by writer thread later.
+	template< typename Literal, typename... Args, EnableIfFormat<Literal> = 0 >
+	static void write( LogLevel level, Literal, const Args&... args )
+	{
+		constexpr FormatCheck check = checkFormat( Literal::text() );
+		static_assert( check.valid, "Wrong braces in format string" );
+		static_assert( check.count == sizeof...( Args ), "Number of '{}' in format string differs from number of arguments" );
+		static_assert( sizeof...( Args ) <= LogEntry::MAX_ARGS, "Too many arguments for log message" );
+		LogEntry* entry = beginEntry( level, Literal::text().data() );
+		(entry->capture( args ), ...);
+		commitEntry( entry );
+	}
+
+private:
+	static LogEntry* beginEntry( LogLevel level, const char* format );
+	static void commitEntry( LogEntry* entry );
+
+	static std::atomic<uint8_t> minLevel;
+};
+
+} // namespace Denom
+
+#endif // Header guard
@@ -0,0 +1,168 @@
+/// Denom.org
+///
+/// MIT No Attribution.
+///
+/// Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software
+/// without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+/// permit persons to whom the Software is furnished to do so.
+///
+/// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+/// PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+/// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+///
+/// Author:  Sergey Novochenko,  Digrol@gmail.com
+///
+/// Class MappedBinary - read-only file, mapped to memory.
+
+#include "stdinc.h"
+
+#include "mappedbinary.h"
+#include "metrics.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#endif
+
+using std::wstring;
+
+namespace Denom {
+
+// ---------------------------------------------------------------------------------------------------------------------
+MappedBinary::MappedBinary( const wstring& filename )
+{
+	open( filename );
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+MappedBinary::MappedBinary( std::string_view filename )
+{
+	open( filename );
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+MappedBinary::~MappedBinary()
+{
+	close();
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+MappedBinary::MappedBinary( MappedBinary&& other ) noexcept
+{
+	*this = std::move( other );
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+MappedBinary& MappedBinary::operator=( MappedBinary&& other ) noexcept
+{
+	if( this != &other )
+	{
+		close();
+		std::swap( ptr, other.ptr );
+		std::swap( length, other.length );
+		#ifdef _WIN32
+			std::swap( hMapping, other.hMapping );
+		#endif
+	}
+	return *this;
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+void MappedBinary::open( const wstring& filename )
+{
+	openNative( toNative( filename ) );
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+void MappedBinary::open( std::string_view filename )
+{
+	openNative( toNative( filename ) );
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+void MappedBinary::openNative( const NativeName& filename )
+{
+	close();
+
+	#ifdef _WIN32
+		HANDLE hFile = CreateFileW( filename.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING,
+			FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, NULL );
+		MUST_M( hFile != INVALID_HANDLE_VALUE, L"Can't open file: " + fromNative( filename ) );
+
+		LARGE_INTEGER fileSize;
+		BOOL ok = GetFileSizeEx( hFile, &fileSize );
+		if( !ok || (fileSize.QuadPart == 0) )
+		{
+			CloseHandle( hFile );
+			MUST_M( ok, L"Can't get file size: " + fromNative( filename ) );
+			return;
+		}
+
+		HANDLE mapping = CreateFileMappingW( hFile, NULL, PAGE_READONLY, 0, 0, NULL );
+		CloseHandle( hFile );
+		MUST_M( mapping != NULL, L"Can't map file: " + fromNative( filename ) );
+
+		void* view = MapViewOfFile( mapping, FILE_MAP_READ, 0, 0, 0 );
+		if( view == NULL )
+		{
+			CloseHandle( mapping );
+			THROW_M( L"Can't map file: " + fromNative( filename ) );
+		}
+
+		hMapping = mapping;
+		ptr = (const uint8_t*)view;
+		length = (size_t)fileSize.QuadPart;
+	#else
+		int fd = ::open( filename.c_str(), O_RDONLY | O_CLOEXEC );
+		MUST_M( fd != -1, L"Can't open file: " + fromNative( filename ) );
+
+		struct stat fileStat;
+		if( fstat( fd, &fileStat ) != 0 )
+		{
+			::close( fd );
+			THROW_M( L"Can't get file size: " + fromNative( filename ) );
+		}
+
+		if( fileStat.st_size == 0 )
+		{
+			::close( fd );
+			return;
+		}
+
+		void* view = mmap( NULL, (size_t)fileStat.st_size, PROT_READ, MAP_PRIVATE, fd, 0 );
+		// Mapping holds its own reference to file
+		::close( fd );
+		MUST_M( view != MAP_FAILED, L"Can't map file: " + fromNative( filename ) );
+
+		madvise( view, (size_t)fileStat.st_size, MADV_SEQUENTIAL );
+
+		ptr = (const uint8_t*)view;
+		length = (size_t)fileStat.st_size;
+	#endif
+
+	static Counter& bytesMapped = Metrics::counter( "file.bytesMapped" );
+	bytesMapped.add( length );
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+void MappedBinary::close()
+{
+	if( ptr != nullptr )
+	{
+		#ifdef _WIN32
+			UnmapViewOfFile( ptr );
+			CloseHandle( hMapping );
+			hMapping = nullptr;
+		#else
+			munmap( (void*)ptr, length );
+		#endif
+	}
+	ptr = nullptr;
+	length = 0;
+}
+
+} // namespace Denom
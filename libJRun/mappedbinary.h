@@ -0,0 +1,91 @@
+/// Denom.org
+///
+/// MIT No Attribution.
+///
+/// Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software
+/// without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+/// permit persons to whom the Software is furnished to do so.
+///
+/// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+/// PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+/// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+///
+/// Author:  Sergey Novochenko,  Digrol@gmail.com
+///
+/// Class MappedBinary - read-only file, mapped to memory.
+
+#ifndef MAPPEDBINARY_H_2A6F0C5B9E14D873
+#define MAPPEDBINARY_H_2A6F0C5B9E14D873
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string>
+#include <string_view>
+#include "binary.h"
+#include "binaryspan.h"
+#include "utils.h"
+
+namespace Denom {
+
+// ---------------------------------------------------------------------------------------------------------------------
+/// Read-only view of file body without copying it to memory.
+/// Pages are read by OS on first access, sequential access is advised.
+/// Useful for hashing and scanning big files, which are read once.
+/// Example:
+///     MappedBinary file( L"lib.jar" );
+///     Binary hash = Sha256().calc( file.data(), file.size() );
+class MappedBinary
+{
+public:
+	MappedBinary() {}
+
+	/// Map whole file. Throws Denom::Exception if file can't be opened.
+	/// @param filename - std::wstring or UTF-8, which is passed to OS as is on Linux, see 'NativeName'.
+	explicit MappedBinary( const std::wstring& filename );
+	explicit MappedBinary( std::string_view filename );
+
+	~MappedBinary();
+
+	MappedBinary( const MappedBinary& ) = delete;
+	MappedBinary& operator=( const MappedBinary& ) = delete;
+
+	MappedBinary( MappedBinary&& other ) noexcept;
+	MappedBinary& operator=( MappedBinary&& other ) noexcept;
+
+	// -----------------------------------------------------------------------------------------------------------------
+	/// Map file, previous file is unmapped.
+	void open( const std::wstring& filename );
+	void open( std::string_view filename );
+
+	/// Unmap file.
+	void close();
+
+	// -----------------------------------------------------------------------------------------------------------------
+	const uint8_t* data() const { return ptr; }
+	size_t size() const { return length; }
+	bool empty() const { return length == 0; }
+
+	const uint8_t* begin() const { return ptr; }
+	const uint8_t* end() const { return ptr + length; }
+
+	uint8_t operator[]( size_t index ) const { return ptr[ index ]; }
+
+	/// View of file body, valid until file is unmapped.
+	operator BinarySpan() const { return BinarySpan( ptr, length ); }
+
+	/// Copy of file body.
+	Binary toBinary() const { return Binary( begin(), end() ); }
+
+private:
+	void openNative( const NativeName& filename );
+
+	const uint8_t* ptr = nullptr;
+	size_t length = 0;
+	#ifdef _WIN32
+		void* hMapping = nullptr;
+	#endif
+};
+
+} // namespace Denom
+
+#endif // Header guard
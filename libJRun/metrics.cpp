@@ -0,0 +1,169 @@
+/// Denom.org
+///
+/// MIT No Attribution.
+///
+/// Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software
+/// without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+/// permit persons to whom the Software is furnished to do so.
+///
+/// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+/// PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+/// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+///
+/// Author:  Sergey Novochenko,  Digrol@gmail.com
+///
+/// Process-wide metrics: counters, gauges and histograms, export to JSON.
+
+#include "stdinc.h"
+
+#include "metrics.h"
+#include "files.h"
+#include "format.h"
+#include <map>
+#include <memory>
+#include <mutex>
+
+namespace {
+
+using Denom::Counter;
+using Denom::Gauge;
+using Denom::LatencyHistogram;
+
+// ---------------------------------------------------------------------------------------------------------------------
+struct Registry
+{
+	std::mutex mutex;
+	std::map< std::string, std::unique_ptr<Counter> > counters;
+	std::map< std::string, std::unique_ptr<Gauge> > gauges;
+	std::map< std::string, std::unique_ptr<LatencyHistogram> > histograms;
+};
+
+// ---------------------------------------------------------------------------------------------------------------------
+Registry& registry()
+{
+	static Registry instance;
+	return instance;
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+template< typename T >
+T& findOrCreate( std::map< std::string, std::unique_ptr<T> >& metrics, const std::string& name )
+{
+	std::lock_guard<std::mutex> lock( registry().mutex );
+	std::unique_ptr<T>& metric = metrics[ name ];
+	if( !metric )
+		metric.reset( new T() );
+	return *metric;
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+void appendJsonString( std::string& out, const std::string& str )
+{
+	out += '"';
+	for( char c : str )
+	{
+		if( (c == '"') || (c == '\\') )
+		{
+			out += '\\';
+			out += c;
+		}
+		else if( (uint8_t)c < 0x20 )
+		{
+			Denom::formatTo( out, FMT( "\\u00{:x}{:x}" ), (uint8_t)c >> 4, (uint8_t)c & 0xF );
+		}
+		else
+		{
+			out += c;
+		}
+	}
+	out += '"';
+}
+
+} // namespace
+
+namespace Denom {
+
+// ---------------------------------------------------------------------------------------------------------------------
+size_t Counter::nextCell()
+{
+	static std::atomic<size_t> next{ 0 };
+	return next.fetch_add( 1, std::memory_order_relaxed );
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+uint64_t Counter::get() const
+{
+	uint64_t sum = 0;
+	for( const Cell& cell : cells )
+		sum += cell.value.load( std::memory_order_relaxed );
+	return sum;
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+Counter& Metrics::counter( const std::string& name )
+{
+	return findOrCreate( registry().counters, name );
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+Gauge& Metrics::gauge( const std::string& name )
+{
+	return findOrCreate( registry().gauges, name );
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+LatencyHistogram& Metrics::histogram( const std::string& name )
+{
+	return findOrCreate( registry().histograms, name );
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+std::string Metrics::toJson()
+{
+	Registry& r = registry();
+	std::lock_guard<std::mutex> lock( r.mutex );
+
+	std::string out = "{\n  \"counters\": {";
+	const char* separator = "\n    ";
+	for( const auto& item : r.counters )
+	{
+		out += separator;
+		appendJsonString( out, item.first );
+		formatTo( out, FMT( ": {}" ), item.second->get() );
+		separator = ",\n    ";
+	}
+
+	out += "\n  },\n  \"gauges\": {";
+	separator = "\n    ";
+	for( const auto& item : r.gauges )
+	{
+		out += separator;
+		appendJsonString( out, item.first );
+		formatTo( out, FMT( ": {}" ), item.second->get() );
+		separator = ",\n    ";
+	}
+
+	out += "\n  },\n  \"histograms\": {";
+	separator = "\n    ";
+	for( const auto& item : r.histograms )
+	{
+		const LatencyHistogram& h = *item.second;
+		out += separator;
+		appendJsonString( out, item.first );
+		formatTo( out, FMT( ": {{\"count\": {}, \"min\": {}, \"mean\": {}, \"p50\": {}, \"p99\": {}, \"max\": {}}}" ),
+			h.getCount(), h.getMin(), h.getMean(), h.p50(), h.p99(), h.getMax() );
+		separator = ",\n    ";
+	}
+
+	out += "\n  }\n}\n";
+	return out;
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+void Metrics::saveJson( const std::wstring& filename )
+{
+	std::string json = toJson();
+	writeFileAtomic( filename, (const uint8_t*)json.data(), json.size() );
+}
+
+} // namespace Denom
@@ -0,0 +1,99 @@
+/// Denom.org
+///
+/// MIT No Attribution.
+///
+/// Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software
+/// without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+/// permit persons to whom the Software is furnished to do so.
+///
+/// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+/// PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+/// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+///
+/// Author:  Sergey Novochenko,  Digrol@gmail.com
+///
+/// Process-wide metrics: counters, gauges and histograms, export to JSON.
+
+#ifndef METRICS_H_3C5A7E19D24B8F60
+#define METRICS_H_3C5A7E19D24B8F60
+
+#include <stdint.h>
+#include <stddef.h>
+#include <atomic>
+#include <string>
+#include "histogram.h"
+
+namespace Denom {
+
+// ---------------------------------------------------------------------------------------------------------------------
+/// Monotonic counter for hot paths. Threads increment different cache lines, so 'add' costs one uncontended
+/// relaxed atomic addition; 'get' sums all cells.
+class Counter
+{
+public:
+	Counter() = default;
+	Counter( const Counter& ) = delete;
+	Counter& operator=( const Counter& ) = delete;
+
+	void add( uint64_t n = 1 )
+	{
+		thread_local size_t cell = nextCell() % CELL_COUNT;
+		cells[ cell ].value.fetch_add( n, std::memory_order_relaxed );
+	}
+
+	uint64_t get() const;
+
+private:
+	static const size_t CELL_COUNT = 16;
+
+	struct alignas( 64 ) Cell
+	{
+		std::atomic<uint64_t> value{ 0 };
+	};
+
+	static size_t nextCell();
+
+	Cell cells[ CELL_COUNT ];
+};
+
+// ---------------------------------------------------------------------------------------------------------------------
+/// Current value of something: size, number of items in use and so on.
+class Gauge
+{
+public:
+	Gauge() = default;
+	Gauge( const Gauge& ) = delete;
+	Gauge& operator=( const Gauge& ) = delete;
+
+	void set( int64_t v ) { value.store( v, std::memory_order_relaxed ); }
+	void add( int64_t n ) { value.fetch_add( n, std::memory_order_relaxed ); }
+	int64_t get() const { return value.load( std::memory_order_relaxed ); }
+
+private:
+	std::atomic<int64_t> value{ 0 };
+};
+
+// ---------------------------------------------------------------------------------------------------------------------
+/// Registry of named metrics. Metric is created by the first request and lives until the end of process,
+/// so reference can be kept in static variable - lookup by name is done once:
+///     static Counter& bytesRead = Metrics::counter( "file.bytesRead" );
+///     bytesRead.add( size );
+/// Histograms hold durations in nanoseconds, see ScopedTimer.
+class Metrics
+{
+public:
+	static Counter& counter( const std::string& name );
+	static Gauge& gauge( const std::string& name );
+	static LatencyHistogram& histogram( const std::string& name );
+
+	/// All metrics, sorted by names:
+	/// {"counters":{"name":1},"gauges":{"name":-1},"histograms":{"name":{"count":1,"min":..,"mean":..,"p50":..,"p99":..,"max":..}}}
+	static std::string toJson();
+
+	/// Write 'toJson' to file atomically.
+	static void saveJson( const std::wstring& filename );
+};
+
+} // namespace Denom
+
+#endif // Header guard
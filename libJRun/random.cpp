@@ -0,0 +1,195 @@
+/// Denom.org
+///
+/// MIT No Attribution.
+///
+/// Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software
+/// without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+/// permit persons to whom the Software is furnished to do so.
+///
+/// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+/// PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+/// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+///
+/// Author:  Sergey Novochenko,  Digrol@gmail.com
+///
+/// Pseudo random and cryptographically secure random numbers.
+
+#include "stdinc.h"
+
+#include "random.h"
+#include "exception.h"
+#include <cstring>
+#include <algorithm>
+#include <cerrno>
+
+#ifdef _WIN32
+	#include <windows.h>
+	#include <bcrypt.h>
+	#pragma comment( lib, "bcrypt.lib" )
+#else
+	#include <fcntl.h>
+	#include <unistd.h>
+	#ifdef __linux__
+		#include <sys/random.h>
+	#endif
+#endif
+
+namespace {
+
+// ---------------------------------------------------------------------------------------------------------------------
+inline uint64_t rotl( uint64_t x, int k )
+{
+	return (x << k) | (x >> (64 - k));
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+/// Expands 64-bit seed into generator state.
+uint64_t splitMix64( uint64_t& x )
+{
+	uint64_t z = (x += 0x9E3779B97F4A7C15ULL);
+	z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+	z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+	return z ^ (z >> 31);
+}
+
+} // namespace
+
+namespace Denom {
+
+// ---------------------------------------------------------------------------------------------------------------------
+void secureRandomFill( uint8_t* buf, size_t size )
+{
+	#ifdef _WIN32
+		while( size > 0 )
+		{
+			ULONG chunk = (ULONG)std::min( size, (size_t)0x10000000 );
+			NTSTATUS status = BCryptGenRandom( nullptr, buf, chunk, BCRYPT_USE_SYSTEM_PREFERRED_RNG );
+			MUST_M( BCRYPT_SUCCESS( status ), L"BCryptGenRandom failed" );
+			buf += chunk;
+			size -= chunk;
+		}
+	#elif defined(__linux__)
+		while( size > 0 )
+		{
+			ssize_t n = getrandom( buf, size, 0 );
+			if( n < 0 )
+			{
+				MUST_M( errno == EINTR, L"getrandom failed" );
+				continue;
+			}
+			buf += n;
+			size -= (size_t)n;
+		}
+	#else
+		int fd = open( "/dev/urandom", O_RDONLY | O_CLOEXEC );
+		MUST_M( fd != -1, L"Can't open /dev/urandom" );
+		while( size > 0 )
+		{
+			ssize_t n = read( fd, buf, size );
+			if( n <= 0 )
+			{
+				if( (n < 0) && (errno == EINTR) )
+					continue;
+				close( fd );
+				THROW_M( L"Can't read /dev/urandom" );
+			}
+			buf += n;
+			size -= (size_t)n;
+		}
+		close( fd );
+	#endif
+}
+
+// =====================================================================================================================
+// Random {
+// =====================================================================================================================
+
+// ---------------------------------------------------------------------------------------------------------------------
+Random::Random()
+{
+	uint64_t seed;
+	secureRandomFill( (uint8_t*)&seed, sizeof(seed) );
+	for( uint64_t& word : s )
+	{
+		// splitmix never gives all-zero state
+		word = splitMix64( seed );
+	}
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+Random::Random( uint64_t seed )
+{
+	for( uint64_t& word : s )
+	{
+		word = splitMix64( seed );
+	}
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+Random& Random::local()
+{
+	static thread_local Random generator;
+	return generator;
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+uint64_t Random::next()
+{
+	uint64_t result = rotl( s[ 1 ] * 5, 7 ) * 9;
+	uint64_t t = s[ 1 ] << 17;
+
+	s[ 2 ] ^= s[ 0 ];
+	s[ 3 ] ^= s[ 1 ];
+	s[ 1 ] ^= s[ 2 ];
+	s[ 0 ] ^= s[ 3 ];
+	s[ 2 ] ^= t;
+	s[ 3 ] = rotl( s[ 3 ], 45 );
+
+	return result;
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+uint32_t Random::range( uint32_t rangeMin, uint32_t rangeMax )
+{
+	MUST_M( rangeMin <= rangeMax, L"Wrong random range" );
+	uint64_t width = (uint64_t)rangeMax - rangeMin + 1;
+	if( width > 0xFFFFFFFFULL )
+	{
+		return (uint32_t)(next() >> 32);
+	}
+
+	// Multiply-and-shift, rejecting low parts that give bias (D. Lemire)
+	uint64_t m = (next() >> 32) * width;
+	uint32_t low = (uint32_t)m;
+	if( low < width )
+	{
+		uint32_t threshold = (uint32_t)((0x100000000ULL - width) % width);
+		while( low < threshold )
+		{
+			m = (next() >> 32) * width;
+			low = (uint32_t)m;
+		}
+	}
+	return rangeMin + (uint32_t)(m >> 32);
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+void Random::fill( uint8_t* buf, size_t size )
+{
+	for( ; size >= 8; size -= 8, buf += 8 )
+	{
+		uint64_t r = next();
+		memcpy( buf, &r, 8 );
+	}
+	if( size > 0 )
+	{
+		uint64_t r = next();
+		memcpy( buf, &r, size );
+	}
+}
+
+// =====================================================================================================================
+// } Random
+// =====================================================================================================================
+
+} // namespace Denom
@@ -0,0 +1,65 @@
+/// Denom.org
+///
+/// MIT No Attribution.
+///
+/// Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software
+/// without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+/// permit persons to whom the Software is furnished to do so.
+///
+/// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+/// PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+/// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+///
+/// Author:  Sergey Novochenko,  Digrol@gmail.com
+///
+/// Pseudo random and cryptographically secure random numbers.
+
+#ifndef RANDOM_H_E3A07C4D1B59F826
+#define RANDOM_H_E3A07C4D1B59F826
+
+#include <stdint.h>
+#include <stddef.h>
+
+namespace Denom {
+
+// ---------------------------------------------------------------------------------------------------------------------
+/// Fast pseudo random generator xoshiro256** (not cryptographically secure).
+/// Object is not thread-safe, use 'Random::local()' - separate generator for each thread.
+/// Example:
+///     uint8_t buf[ 16 ];
+///     Random::local().fill( buf, sizeof(buf) );
+class Random
+{
+public:
+	/// Seeded from OS entropy.
+	Random();
+
+	/// Reproducible sequence, for test data.
+	explicit Random( uint64_t seed );
+
+	/// Generator of current thread, seeded from OS entropy on first use.
+	static Random& local();
+
+	// -----------------------------------------------------------------------------------------------------------------
+	/// Next 64 random bits.
+	uint64_t next();
+
+	/// Uniformly distributed number in [rangeMin, rangeMax], without modulo bias.
+	uint32_t range( uint32_t rangeMin, uint32_t rangeMax );
+
+	/// Fill buffer with random bytes, 8 bytes per step.
+	void fill( uint8_t* buf, size_t size );
+
+private:
+	uint64_t s[ 4 ];
+};
+
+// ---------------------------------------------------------------------------------------------------------------------
+/// Fill buffer with cryptographically secure random bytes from OS:
+/// getrandom() on Linux, /dev/urandom on other Unix, BCryptGenRandom on Windows.
+/// Throws Denom::Exception if OS generator is not available.
+void secureRandomFill( uint8_t* buf, size_t size );
+
+} // namespace Denom
+
+#endif // Header guard
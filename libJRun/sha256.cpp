@@ -1,15 +1,48 @@
+/// Denom.org
+///
+/// MIT No Attribution.
+///
+/// Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software
+/// without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+/// permit persons to whom the Software is furnished to do so.
+///
+/// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+/// PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+/// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+///
+/// Author:  Sergey Novochenko,  Digrol@gmail.com
+///
+/// SHA-1 and SHA-256 hash functions.
 
 #include "stdinc.h"
 
-#if 0
+#include "sha256.h"
+#include "metrics.h"
+
+namespace {
+
+#define ROTR_U32( x, n ) ( ((x) >> (n)) | ((x) << (32 - (n))) )
+#define ROTL_U32( x, n ) ( ((x) << (n)) | ((x) >> (32 - (n))) )
+
+/// Read BigEndian U32 from byte array
+#define READ_U32( p ) ( ((uint32_t)(p)[0] << 24) | ((uint32_t)(p)[1] << 16) | ((uint32_t)(p)[2] << 8) | (uint32_t)(p)[3] )
 
 // ---------------------------------------------------------------------------------------------------------------------
-typedef void FUNCT_TRANSFORM( SHA256_CTX* ctx, const uint8_t data[] );
+/// Write U32 to byte array in BigEndian
+void writeU32( uint8_t* p, uint32_t num )
+{
+	p[ 0 ] = (uint8_t)(num >> 24);
+	p[ 1 ] = (uint8_t)(num >> 16);
+	p[ 2 ] = (uint8_t)(num >> 8);
+	p[ 3 ] = (uint8_t)num;
+}
 
-FUNCT_TRANSFORM *do_transform;
+} // namespace
+
+namespace Denom {
 
 // ---------------------------------------------------------------------------------------------------------------------
-static const uint32_t SHA256_CONST[64] = {
+const uint32_t SHA256_CONST[64] = {
 	0x428a2f98,0x71374491,0xb5c0fbcf,0xe9b5dba5,0x3956c25b,0x59f111f1,0x923f82a4,0xab1c5ed5,
 	0xd807aa98,0x12835b01,0x243185be,0x550c7dc3,0x72be5d74,0x80deb1fe,0x9bdc06a7,0xc19bf174,
 	0xe49b69c1,0xefbe4786,0x0fc19dc6,0x240ca1cc,0x2de92c6f,0x4a7484aa,0x5cb0a9dc,0x76f988da,
@@ -21,68 +54,71 @@ static const uint32_t SHA256_CONST[64] = {
 };
 
 // ---------------------------------------------------------------------------------------------------------------------
-void sha256_transform( SHA256_CTX* ctx, const uint8_t data[] )
+void sha256_transform( SHA256_CTX* ctx, const uint8_t data[], size_t blocks )
 {
-	uint32_t a = ctx->state[ 0 ];
-	uint32_t b = ctx->state[ 1 ];
-	uint32_t c = ctx->state[ 2 ];
-	uint32_t d = ctx->state[ 3 ];
-	uint32_t e = ctx->state[ 4 ];
-	uint32_t f = ctx->state[ 5 ];
-	uint32_t g = ctx->state[ 6 ];
-	uint32_t h = ctx->state[ 7 ];
-
-	uint32_t t1;
-	uint8_t i;
-
-	uint32_t W[16];
-
-	for( i = 0; i < 16; ++i )
-	{
-		W[ i ] = READ_U32( data );
-		data += sizeof(uint32_t);
-	}
-
-	for( i = 0; i < 16; ++i )
-	{
-		t1 = h + (ROTR_U32(e, 6) ^ ROTR_U32(e, 11) ^ ROTR_U32(e, 25))
-			+ ((e & f) ^ (~e & g)) + SHA256_CONST[ i ] + W[ i ];
-		h = g;
-		g = f;
-		f = e;
-		e = d + t1;
-		d = c;
-		c = b;
-		b = a;
-		a = t1 + (ROTR_U32(a, 2) ^ ROTR_U32(a, 13) ^ ROTR_U32(a, 22))  +  ((a & c) ^ (a & d) ^ (c & d));
-	}
-
-	for( ; i < 64; ++i )
+	for( ; blocks != 0; --blocks )
 	{
-		W[ i & 0x0F ] += W[(i - 7) & 0x0F]
-			+ (ROTR_U32( W[(i - 15) & 0x0F], 7 )  ^ ROTR_U32( W[(i - 15) & 0x0F], 18 ) ^ (W[(i - 15) & 0x0F] >> 3))
-			+ (ROTR_U32( W[(i - 2)  & 0x0F], 17 ) ^ ROTR_U32( W[(i - 2)  & 0x0F], 19 ) ^ (W[(i - 2)  & 0x0F] >> 10));
-
-		t1 = h + (ROTR_U32( e, 6 ) ^ ROTR_U32( e, 11 ) ^ ROTR_U32( e, 25 ))
-			+ ((e & f) ^ (~e & g)) + SHA256_CONST[ i ] + W[ i & 0x0F ];
-		h = g;
-		g = f;
-		f = e;
-		e = d + t1;
-		d = c;
-		c = b;
-		b = a;
-		a = t1 + (ROTR_U32(a, 2) ^ ROTR_U32(a, 13) ^ ROTR_U32(a, 22))  +  ((a & c) ^ (a & d) ^ (c & d));
+		uint32_t a = ctx->state[ 0 ];
+		uint32_t b = ctx->state[ 1 ];
+		uint32_t c = ctx->state[ 2 ];
+		uint32_t d = ctx->state[ 3 ];
+		uint32_t e = ctx->state[ 4 ];
+		uint32_t f = ctx->state[ 5 ];
+		uint32_t g = ctx->state[ 6 ];
+		uint32_t h = ctx->state[ 7 ];
+
+		uint32_t t1;
+		uint8_t i;
+
+		uint32_t W[16];
+
+		for( i = 0; i < 16; ++i )
+		{
+			W[ i ] = READ_U32( data );
+			data += sizeof(uint32_t);
+		}
+
+		for( i = 0; i < 16; ++i )
+		{
+			t1 = h + (ROTR_U32(e, 6) ^ ROTR_U32(e, 11) ^ ROTR_U32(e, 25))
+				+ ((e & f) ^ (~e & g)) + SHA256_CONST[ i ] + W[ i ];
+			h = g;
+			g = f;
+			f = e;
+			e = d + t1;
+			d = c;
+			c = b;
+			b = a;
+			a = t1 + (ROTR_U32(a, 2) ^ ROTR_U32(a, 13) ^ ROTR_U32(a, 22))  +  ((a & c) ^ (a & d) ^ (c & d));
+		}
+
+		for( ; i < 64; ++i )
+		{
+			W[ i & 0x0F ] += W[(i - 7) & 0x0F]
+				+ (ROTR_U32( W[(i - 15) & 0x0F], 7 )  ^ ROTR_U32( W[(i - 15) & 0x0F], 18 ) ^ (W[(i - 15) & 0x0F] >> 3))
+				+ (ROTR_U32( W[(i - 2)  & 0x0F], 17 ) ^ ROTR_U32( W[(i - 2)  & 0x0F], 19 ) ^ (W[(i - 2)  & 0x0F] >> 10));
+
+			t1 = h + (ROTR_U32( e, 6 ) ^ ROTR_U32( e, 11 ) ^ ROTR_U32( e, 25 ))
+				+ ((e & f) ^ (~e & g)) + SHA256_CONST[ i ] + W[ i & 0x0F ];
+			h = g;
+			g = f;
+			f = e;
+			e = d + t1;
+			d = c;
+			c = b;
+			b = a;
+			a = t1 + (ROTR_U32(a, 2) ^ ROTR_U32(a, 13) ^ ROTR_U32(a, 22))  +  ((a & c) ^ (a & d) ^ (c & d));
+		}
+
+		ctx->state[0] += a;
+		ctx->state[1] += b;
+		ctx->state[2] += c;
+		ctx->state[3] += d;
+		ctx->state[4] += e;
+		ctx->state[5] += f;
+		ctx->state[6] += g;
+		ctx->state[7] += h;
 	}
-
-	ctx->state[0] += a;
-	ctx->state[1] += b;
-	ctx->state[2] += c;
-	ctx->state[3] += d;
-	ctx->state[4] += e;
-	ctx->state[5] += f;
-	ctx->state[6] += g;
-	ctx->state[7] += h;
 }
 
 // ---------------------------------------------------------------------------------------------------------------------
@@ -97,7 +133,7 @@ void sha256_init( SHA256_CTX* ctx )
 	ctx->state[5] = 0x9b05688c;
 	ctx->state[6] = 0x1f83d9ab;
 	ctx->state[7] = 0x5be0cd19;
-	do_transform = sha256_transform;
+	ctx->transform = sha256_best_transform();
 }
 
 // ---------------------------------------------------------------------------------------------------------------------
@@ -112,31 +148,11 @@ void sha224_init( SHA256_CTX* ctx )
 	ctx->state[5] = 0x68581511;
 	ctx->state[6] = 0x64F98FA7;
 	ctx->state[7] = 0xBEFA4FA4;
-	do_transform = sha256_transform;
+	ctx->transform = sha256_best_transform();
 }
 
 // ---------------------------------------------------------------------------------------------------------------------
-BoolSecure sha_set_state( SHA256_CTX* ctx, const uint8_t* state, uint16_t stateLen, uint32_t processedLen[ 2 ] )
-{
-	uint16_t i;
-	if( (stateLen != 20) && (stateLen != 32) )
-		return SECURE_FALSE_8;
-
-	ctx->total[ 0 ] = processedLen[ 0 ];
-	ctx->total[ 1 ] = processedLen[ 1 ];
-
-	stateLen >>= 2;
-	for( i = 0; i < stateLen; ++i )
-	{
-		ctx->state[ i ] = READ_U32( state );
-		state += sizeof(uint32_t);
-	}
-
-	return SECURE_TRUE_8;
-}
-
-// ---------------------------------------------------------------------------------------------------------------------
-void sha_update( SHA256_CTX* ctx, const uint8_t msg[], uint32_t msgLen )
+void sha_update( SHA256_CTX* ctx, const uint8_t msg[], size_t msgLen )
 {
 	uint8_t fill;
 	uint32_t left;
@@ -144,28 +160,31 @@ void sha_update( SHA256_CTX* ctx, const uint8_t msg[], uint32_t msgLen )
 	if( msgLen == 0 )
 		return;
 
+	static Counter& bytesHashed = Metrics::counter( "hash.bytesHashed" );
+	bytesHashed.add( msgLen );
+
 	left = ctx->total[ 0 ] & 0x3F;
 	fill = 64 - left;
 
-	ctx->total[ 0 ] += msgLen;
-
-	if( ctx->total[ 0 ] < msgLen )
-		ctx->total[ 1 ]++;
+	uint64_t total = (((uint64_t)ctx->total[ 1 ]) << 32) + ctx->total[ 0 ] + msgLen;
+	ctx->total[ 0 ] = (uint32_t)total;
+	ctx->total[ 1 ] = (uint32_t)(total >> 32);
 
 	if( left && (msgLen >= fill) )
 	{
 		memcpy( ctx->data + left, msg, fill );
-		do_transform( ctx, ctx->data );
+		ctx->transform( ctx, ctx->data, 1 );
 		msg += fill;
 		msgLen -= fill;
 		left = 0;
 	}
 
-	while( msgLen >= 64 )
+	if( msgLen >= 64 )
 	{
-		do_transform( ctx, msg );
-		msg += 64;
-		msgLen -= 64;
+		size_t blocks = msgLen >> 6;
+		ctx->transform( ctx, msg, blocks );
+		msg += blocks << 6;
+		msgLen &= 0x3F;
 	}
 
 	if( msgLen > 0 )
@@ -183,14 +202,14 @@ void sha_final( SHA256_CTX* ctx )
 	memset(ctx->data + i, 0, 64 - i);
 	if ( leftBytes >= (64 - 8))
 	{
-		do_transform(ctx, ctx->data );
+		ctx->transform( ctx, ctx->data, 1 );
 		memset(ctx->data, 0, 56);
 	}
 
 	// Total len in bits, BigEndian
 	writeU32( ctx->data + 56, (ctx->total[ 0 ] >> 29) | (ctx->total[ 1 ] << 3) );
 	writeU32( ctx->data + 60, (ctx->total[ 0 ] << 3) );
-	do_transform( ctx, ctx->data );
+	ctx->transform( ctx, ctx->data, 1 );
 
 	for( i = 0; i < sizeof(ctx->state); i += 4 )
 		writeU32( ctx->data + i, ctx->state[ i >> 2 ] );
@@ -202,83 +221,86 @@ void sha_final( SHA256_CTX* ctx )
 	W[ i & 0x0F ] = ROTL_U32( t, 1 );
 
 // ---------------------------------------------------------------------------------------------------------------------
-void sha1_transform( SHA256_CTX *ctx, const uint8_t data[] )
+static void sha1_transform( SHA256_CTX* ctx, const uint8_t data[], size_t blocks )
 {
-	uint32_t a = ctx->state[0];
-	uint32_t b = ctx->state[1];
-	uint32_t c = ctx->state[2];
-	uint32_t d = ctx->state[3];
-	uint32_t e = ctx->state[4];
-
-	uint32_t i;
-	uint32_t t;
-	uint32_t W[ 16 ];
-
-	for( i = 0; i < 16; ++i )
-	{
-		W[ i ] = READ_U32( data );
-		data += sizeof(uint32_t);
-	}
-
-	for( i = 0; i < 16; ++i )
-	{
-		t = ROTL_U32( a, 5 ) + ((b & c) ^ (~b & d)) + e + 0x5a827999 + W[ i ];
-		e = d;
-		d = c;
-		c = ROTL_U32( b, 30 );
-		b = a;
-		a = t;
-	}
-
-	for( ; i < 20; ++i )
-	{
-		SHA1_DATA_WORD( i );
-		t = ROTL_U32( a, 5 ) + ((b & c) ^ (~b & d)) + e + 0x5a827999 + W[ i & 0x0F ];
-		e = d;
-		d = c;
-		c = ROTL_U32( b, 30 );
-		b = a;
-		a = t;
-	}
-
-	for ( ; i < 40; ++i)
-	{
-		SHA1_DATA_WORD( i );
-		t = ROTL_U32(a, 5) + (b ^ c ^ d) + e + 0x6ed9eba1 + W[ i & 0x0F ];
-		e = d;
-		d = c;
-		c = ROTL_U32(b, 30);
-		b = a;
-		a = t;
-	}
-
-	for ( ; i < 60; ++i)
-	{
-		SHA1_DATA_WORD( i );
-		t = ROTL_U32(a, 5) + ((b & c) ^ (b & d) ^ (c & d))  + e + 0x8f1bbcdc + W[ i & 0x0F ];
-		e = d;
-		d = c;
-		c = ROTL_U32(b, 30);
-		b = a;
-		a = t;
-	}
-
-	for ( ; i < 80; ++i)
+	for( ; blocks != 0; --blocks )
 	{
-		SHA1_DATA_WORD( i );
-		t = ROTL_U32(a, 5) + (b ^ c ^ d) + e + 0xca62c1d6 + W[ i & 0x0F ];
-		e = d;
-		d = c;
-		c = ROTL_U32(b, 30);
-		b = a;
-		a = t;
+		uint32_t a = ctx->state[0];
+		uint32_t b = ctx->state[1];
+		uint32_t c = ctx->state[2];
+		uint32_t d = ctx->state[3];
+		uint32_t e = ctx->state[4];
+
+		uint32_t i;
+		uint32_t t;
+		uint32_t W[ 16 ];
+
+		for( i = 0; i < 16; ++i )
+		{
+			W[ i ] = READ_U32( data );
+			data += sizeof(uint32_t);
+		}
+
+		for( i = 0; i < 16; ++i )
+		{
+			t = ROTL_U32( a, 5 ) + ((b & c) ^ (~b & d)) + e + 0x5a827999 + W[ i ];
+			e = d;
+			d = c;
+			c = ROTL_U32( b, 30 );
+			b = a;
+			a = t;
+		}
+
+		for( ; i < 20; ++i )
+		{
+			SHA1_DATA_WORD( i );
+			t = ROTL_U32( a, 5 ) + ((b & c) ^ (~b & d)) + e + 0x5a827999 + W[ i & 0x0F ];
+			e = d;
+			d = c;
+			c = ROTL_U32( b, 30 );
+			b = a;
+			a = t;
+		}
+
+		for ( ; i < 40; ++i)
+		{
+			SHA1_DATA_WORD( i );
+			t = ROTL_U32(a, 5) + (b ^ c ^ d) + e + 0x6ed9eba1 + W[ i & 0x0F ];
+			e = d;
+			d = c;
+			c = ROTL_U32(b, 30);
+			b = a;
+			a = t;
+		}
+
+		for ( ; i < 60; ++i)
+		{
+			SHA1_DATA_WORD( i );
+			t = ROTL_U32(a, 5) + ((b & c) ^ (b & d) ^ (c & d))  + e + 0x8f1bbcdc + W[ i & 0x0F ];
+			e = d;
+			d = c;
+			c = ROTL_U32(b, 30);
+			b = a;
+			a = t;
+		}
+
+		for ( ; i < 80; ++i)
+		{
+			SHA1_DATA_WORD( i );
+			t = ROTL_U32(a, 5) + (b ^ c ^ d) + e + 0xca62c1d6 + W[ i & 0x0F ];
+			e = d;
+			d = c;
+			c = ROTL_U32(b, 30);
+			b = a;
+			a = t;
+		}
+
+		ctx->state[0] += a;
+		ctx->state[1] += b;
+		ctx->state[2] += c;
+		ctx->state[3] += d;
+		ctx->state[4] += e;
 	}
-
-	ctx->state[0] += a;
-	ctx->state[1] += b;
-	ctx->state[2] += c;
-	ctx->state[3] += d;
-	ctx->state[4] += e;
 }
 
 // ---------------------------------------------------------------------------------------------------------------------
@@ -290,39 +312,85 @@ void sha1_init( SHA256_CTX *ctx )
 	ctx->state[2] = 0x98BADCFE;
 	ctx->state[3] = 0x10325476;
 	ctx->state[4] = 0xc3d2e1f0;
-	do_transform = sha1_transform;
+	ctx->transform = sha1_transform;
 }
 
 // ---------------------------------------------------------------------------------------------------------------------
-uint16_t sha_getCtxSize()
+void calcHashSHA1( const uint8_t* data, size_t length, uint8_t* bufHash )
 {
-	return sizeof( SHA256_CTX );
+	SHA256_CTX ctx;
+	sha1_init( &ctx );
+	sha_update( &ctx, data, length );
+	sha_final( &ctx );
+	memcpy( bufHash, ctx.data, HASH_SIZE_SHA1 );
 }
 
 // ---------------------------------------------------------------------------------------------------------------------
-void calcHashSHA1( const uint8_t* data, uint32_t length, uint8_t* bufHash )
+void calcHashSHA256( const uint8_t* data, size_t length, uint8_t* bufHash )
 {
 	SHA256_CTX ctx;
+	sha256_init( &ctx );
+	sha_update( &ctx, data, length );
+	sha_final( &ctx );
+	memcpy( bufHash, ctx.data, HASH_SIZE_SHA256 );
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+Binary calcHashSHA256( const Binary& data )
+{
+	Binary hash( HASH_SIZE_SHA256 );
+	calcHashSHA256( data.data(), data.size(), hash.data() );
+	return hash;
+}
+
+// =====================================================================================================================
+// Sha1
+// =====================================================================================================================
+
+// ---------------------------------------------------------------------------------------------------------------------
+void Sha1::reset()
+{
 	sha1_init( &ctx );
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+void Sha1::process( const uint8_t* data, size_t length )
+{
 	sha_update( &ctx, data, length );
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+Binary Sha1::getHash()
+{
 	sha_final( &ctx );
-	memcpy( bufHash, ctx.data, HASH_SIZE_SHA1 );
+	Binary hash( ctx.data, ctx.data + HASH_SIZE_SHA1 );
+	reset();
+	return hash;
 }
 
+// =====================================================================================================================
+// Sha256
+// =====================================================================================================================
+
 // ---------------------------------------------------------------------------------------------------------------------
-void calcHashSHA256( const uint8_t* data, uint32_t length, uint8_t* bufHash )
+void Sha256::reset()
 {
-	SHA256_CTX ctx;
-	calcHashSHA256CTX( &ctx, data, length, bufHash );
+	sha256_init( &ctx );
 }
 
 // ---------------------------------------------------------------------------------------------------------------------
-void calcHashSHA256CTX( SHA256_CTX* ctx, const uint8_t* data, uint32_t length, uint8_t* bufHash )
+void Sha256::process( const uint8_t* data, size_t length )
 {
-	sha256_init( ctx );
-	sha_update( ctx, data, length );
-	sha_final( ctx );
-	memcpy( bufHash, ctx->data, HASH_SIZE_SHA256 );
+	sha_update( &ctx, data, length );
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+Binary Sha256::getHash()
+{
+	sha_final( &ctx );
+	Binary hash( ctx.data, ctx.data + HASH_SIZE_SHA256 );
+	reset();
+	return hash;
 }
 
-#endif
+} // namespace Denom
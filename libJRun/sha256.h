@@ -1,15 +1,129 @@
+/// Denom.org
+///
+/// MIT No Attribution.
+///
+/// Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software
+/// without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+/// permit persons to whom the Software is furnished to do so.
+///
+/// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+/// PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+/// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+///
+/// Author:  Sergey Novochenko,  Digrol@gmail.com
+///
+/// SHA-1 and SHA-256 hash functions.
 
+#ifndef SHA256_H_6B0D5E2A71C94F38
+#define SHA256_H_6B0D5E2A71C94F38
 
-/**
- * Abstract cryptographic hash function.
- * Processes binary data and produces 'hash' (another byte array).
- * 1. Calculating hash in one step:
- *      Binary hash = new IHash().calc( data );
- * 2. Calculating hash by parts, using 'reset', 'process', 'getHash':
- *      IHash alg = new IHash();
- *      alg.process( part1 );
- *      alg.process( partN );
- *      Binary hash = alg.getHash();
- */
+#include <stdint.h>
+#include <stddef.h>
+#include "binary.h"
+#include "ihash.h"
 
+namespace Denom {
 
+const uint32_t HASH_SIZE_SHA1   = 20;
+const uint32_t HASH_SIZE_SHA256 = 32;
+
+// ---------------------------------------------------------------------------------------------------------------------
+/// Context of SHA-1 / SHA-224 / SHA-256 calculation.
+struct SHA256_CTX;
+
+/// Processes 'blocks' consecutive 64-byte blocks.
+typedef void FUNCT_TRANSFORM( SHA256_CTX* ctx, const uint8_t data[], size_t blocks );
+
+struct SHA256_CTX
+{
+	uint32_t state[ 8 ];
+	uint32_t total[ 2 ];        // number of processed bytes: [0] - low part, [1] - high part
+	uint8_t data[ 64 ];         // unprocessed tail; after 'sha_final' - hash value
+	FUNCT_TRANSFORM* transform; // set by init-function
+};
+
+// ---------------------------------------------------------------------------------------------------------------------
+void sha1_init( SHA256_CTX* ctx );
+void sha224_init( SHA256_CTX* ctx );
+void sha256_init( SHA256_CTX* ctx );
+
+/// Continue hash calculation with the next part of message.
+void sha_update( SHA256_CTX* ctx, const uint8_t msg[], size_t msgLen );
+
+/// Finish calculation. Hash value is placed to the beginning of 'ctx->data'.
+void sha_final( SHA256_CTX* ctx );
+
+// ---------------------------------------------------------------------------------------------------------------------
+/// Calculate hash in one step.
+/// @param bufHash - buffer for HASH_SIZE_SHA1 / HASH_SIZE_SHA256 bytes.
+void calcHashSHA1( const uint8_t* data, size_t length, uint8_t* bufHash );
+void calcHashSHA256( const uint8_t* data, size_t length, uint8_t* bufHash );
+
+Binary calcHashSHA256( const Binary& data );
+
+// ---------------------------------------------------------------------------------------------------------------------
+/// Calculate SHA-256 of 'count' independent messages.
+/// With AVX2 messages are hashed by groups of 8 in parallel lanes.
+/// @param hashes - buffer for count * HASH_SIZE_SHA256 bytes.
+void calcHashSHA256Multi( const uint8_t* const data[], const size_t lengths[], size_t count, uint8_t* hashes );
+
+// ---------------------------------------------------------------------------------------------------------------------
+/// SHA-256 implementation is chosen once, by CPU features:
+/// SHA extensions (SHA-NI) for single messages, AVX2 for multi-buffer hashing, otherwise - portable code.
+/// @return names of chosen implementations, for diagnostics. Example: "SHA-NI, AVX2 x8".
+std::string sha256ImplName();
+
+/// Checks all SHA-256 implementations, supported by this CPU, with standard test vectors,
+/// and 'calcHashSHA256Multi' against hashing of each message. Run by 'jrun --self-test'.
+bool sha256SelfTest();
+
+/// Implementations of SHA-256 'transform'. Used by 'sha256_init'.
+extern const uint32_t SHA256_CONST[ 64 ];
+void sha256_transform( SHA256_CTX* ctx, const uint8_t data[], size_t blocks );
+FUNCT_TRANSFORM* sha256_best_transform();
+
+// ---------------------------------------------------------------------------------------------------------------------
+class Sha1 : public IHash
+{
+public:
+	Sha1() { reset(); }
+
+	IHash* clone() const override { return new Sha1(); }
+	IHash* cloneState() const override { return new Sha1( *this ); }
+	uint32_t getSize() const override { return HASH_SIZE_SHA1; }
+	std::wstring getName() const override { return L"SHA-1"; }
+
+	void reset() override;
+	void process( const uint8_t* data, size_t length ) override;
+	Binary getHash() override;
+
+	using IHash::process;
+
+private:
+	SHA256_CTX ctx;
+};
+
+// ---------------------------------------------------------------------------------------------------------------------
+class Sha256 : public IHash
+{
+public:
+	Sha256() { reset(); }
+
+	IHash* clone() const override { return new Sha256(); }
+	IHash* cloneState() const override { return new Sha256( *this ); }
+	uint32_t getSize() const override { return HASH_SIZE_SHA256; }
+	std::wstring getName() const override { return L"SHA-256"; }
+
+	void reset() override;
+	void process( const uint8_t* data, size_t length ) override;
+	Binary getHash() override;
+
+	using IHash::process;
+
+private:
+	SHA256_CTX ctx;
+};
+
+} // namespace Denom
+
+#endif // Header guard
@@ -0,0 +1,448 @@
+/// Denom.org
+///
+/// MIT No Attribution.
+///
+/// Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software
+/// without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+/// permit persons to whom the Software is furnished to do so.
+///
+/// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+/// PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+/// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+///
+/// Author:  Sergey Novochenko,  Digrol@gmail.com
+///
+/// SHA-256 with x86 SHA extensions and AVX2, choosing implementation by CPU features.
+
+#include "stdinc.h"
+
+#include "sha256.h"
+#include "cpu.h"
+#include "metrics.h"
+#include "trace.h"
+
+#ifdef DENOM_X86
+	#include <immintrin.h>
+#endif
+
+using std::string;
+
+namespace Denom {
+
+namespace {
+
+const uint32_t SHA256_IV[ 8 ] = {
+	0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19
+};
+
+#ifdef DENOM_X86
+
+// =====================================================================================================================
+// SHA extensions
+// =====================================================================================================================
+
+/// 4 rounds with message words 'cur'. Message schedule for next rounds is calculated between them.
+/// Rounds 12..59 finish next words with SHA256MSG2, rounds 4..51 start them with SHA256MSG1.
+#define SHANI_ROUNDS4( g, cur, prev, next ) \
+	m = _mm_add_epi32( cur, _mm_loadu_si128( (const __m128i*)(SHA256_CONST + 4 * (g)) ) ); \
+	state1 = _mm_sha256rnds2_epu32( state1, state0, m ); \
+	if( ((g) >= 3) && ((g) <= 14) ) \
+	{ \
+		next = _mm_add_epi32( next, _mm_alignr_epi8( cur, prev, 4 ) ); \
+		next = _mm_sha256msg2_epu32( next, cur ); \
+	} \
+	m = _mm_shuffle_epi32( m, 0x0E ); \
+	state0 = _mm_sha256rnds2_epu32( state0, state1, m ); \
+	if( ((g) >= 1) && ((g) <= 12) ) \
+		prev = _mm_sha256msg1_epu32( prev, cur );
+
+// ---------------------------------------------------------------------------------------------------------------------
+DENOM_TARGET( "sha,sse4.1" )
+void sha256_transform_shani( SHA256_CTX* ctx, const uint8_t data[], size_t blocks )
+{
+	const __m128i BSWAP_MASK = _mm_set_epi64x( 0x0c0d0e0f08090a0bULL, 0x0405060700010203ULL );
+
+	// State is kept as ABEF / CDGH
+	__m128i tmp = _mm_loadu_si128( (const __m128i*)&ctx->state[ 0 ] );
+	__m128i state1 = _mm_loadu_si128( (const __m128i*)&ctx->state[ 4 ] );
+	tmp = _mm_shuffle_epi32( tmp, 0xB1 );               // CDAB
+	state1 = _mm_shuffle_epi32( state1, 0x1B );         // EFGH
+	__m128i state0 = _mm_alignr_epi8( tmp, state1, 8 ); // ABEF
+	state1 = _mm_blend_epi16( state1, tmp, 0xF0 );      // CDGH
+
+	for( ; blocks != 0; --blocks, data += 64 )
+	{
+		__m128i abefSave = state0;
+		__m128i cdghSave = state1;
+		__m128i m;
+
+		__m128i m0 = _mm_shuffle_epi8( _mm_loadu_si128( (const __m128i*)(data +  0) ), BSWAP_MASK );
+		__m128i m1 = _mm_shuffle_epi8( _mm_loadu_si128( (const __m128i*)(data + 16) ), BSWAP_MASK );
+		__m128i m2 = _mm_shuffle_epi8( _mm_loadu_si128( (const __m128i*)(data + 32) ), BSWAP_MASK );
+		__m128i m3 = _mm_shuffle_epi8( _mm_loadu_si128( (const __m128i*)(data + 48) ), BSWAP_MASK );
+
+		SHANI_ROUNDS4(  0, m0, m3, m1 );
+		SHANI_ROUNDS4(  1, m1, m0, m2 );
+		SHANI_ROUNDS4(  2, m2, m1, m3 );
+		SHANI_ROUNDS4(  3, m3, m2, m0 );
+		SHANI_ROUNDS4(  4, m0, m3, m1 );
+		SHANI_ROUNDS4(  5, m1, m0, m2 );
+		SHANI_ROUNDS4(  6, m2, m1, m3 );
+		SHANI_ROUNDS4(  7, m3, m2, m0 );
+		SHANI_ROUNDS4(  8, m0, m3, m1 );
+		SHANI_ROUNDS4(  9, m1, m0, m2 );
+		SHANI_ROUNDS4( 10, m2, m1, m3 );
+		SHANI_ROUNDS4( 11, m3, m2, m0 );
+		SHANI_ROUNDS4( 12, m0, m3, m1 );
+		SHANI_ROUNDS4( 13, m1, m0, m2 );
+		SHANI_ROUNDS4( 14, m2, m1, m3 );
+		SHANI_ROUNDS4( 15, m3, m2, m0 );
+
+		state0 = _mm_add_epi32( state0, abefSave );
+		state1 = _mm_add_epi32( state1, cdghSave );
+	}
+
+	tmp = _mm_shuffle_epi32( state0, 0x1B );            // FEBA
+	state1 = _mm_shuffle_epi32( state1, 0xB1 );         // DCHG
+	state0 = _mm_blend_epi16( tmp, state1, 0xF0 );      // DCBA
+	state1 = _mm_alignr_epi8( state1, tmp, 8 );         // ABEF -> HGFE
+	_mm_storeu_si128( (__m128i*)&ctx->state[ 0 ], state0 );
+	_mm_storeu_si128( (__m128i*)&ctx->state[ 4 ], state1 );
+}
+
+#undef SHANI_ROUNDS4
+
+// =====================================================================================================================
+// AVX2, 8 lanes
+// =====================================================================================================================
+
+DENOM_TARGET( "avx2" ) inline __m256i rotr( __m256i x, int n )
+{
+	return _mm256_or_si256( _mm256_srli_epi32( x, n ), _mm256_slli_epi32( x, 32 - n ) );
+}
+
+DENOM_TARGET( "avx2" ) inline __m256i add( __m256i a, __m256i b )
+{
+	return _mm256_add_epi32( a, b );
+}
+
+DENOM_TARGET( "avx2" ) inline __m256i xor3( __m256i a, __m256i b, __m256i c )
+{
+	return _mm256_xor_si256( _mm256_xor_si256( a, b ), c );
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+/// Processes one block in each of 8 lanes.
+/// @param state - [word][lane].
+DENOM_TARGET( "avx2" )
+void sha256_transform_x8_avx2( uint32_t state[ 8 ][ 8 ], const uint8_t* const blocks[ 8 ] )
+{
+	__m256i W[ 16 ];
+	for( int t = 0; t < 16; ++t )
+	{
+		const uint8_t* p[ 8 ];
+		for( int lane = 0; lane < 8; ++lane )
+			p[ lane ] = blocks[ lane ] + 4 * t;
+
+		W[ t ] = _mm256_setr_epi32(
+			(int)(((uint32_t)p[0][0] << 24) | ((uint32_t)p[0][1] << 16) | ((uint32_t)p[0][2] << 8) | p[0][3]),
+			(int)(((uint32_t)p[1][0] << 24) | ((uint32_t)p[1][1] << 16) | ((uint32_t)p[1][2] << 8) | p[1][3]),
+			(int)(((uint32_t)p[2][0] << 24) | ((uint32_t)p[2][1] << 16) | ((uint32_t)p[2][2] << 8) | p[2][3]),
+			(int)(((uint32_t)p[3][0] << 24) | ((uint32_t)p[3][1] << 16) | ((uint32_t)p[3][2] << 8) | p[3][3]),
+			(int)(((uint32_t)p[4][0] << 24) | ((uint32_t)p[4][1] << 16) | ((uint32_t)p[4][2] << 8) | p[4][3]),
+			(int)(((uint32_t)p[5][0] << 24) | ((uint32_t)p[5][1] << 16) | ((uint32_t)p[5][2] << 8) | p[5][3]),
+			(int)(((uint32_t)p[6][0] << 24) | ((uint32_t)p[6][1] << 16) | ((uint32_t)p[6][2] << 8) | p[6][3]),
+			(int)(((uint32_t)p[7][0] << 24) | ((uint32_t)p[7][1] << 16) | ((uint32_t)p[7][2] << 8) | p[7][3]) );
+	}
+
+	__m256i a = _mm256_loadu_si256( (const __m256i*)state[ 0 ] );
+	__m256i b = _mm256_loadu_si256( (const __m256i*)state[ 1 ] );
+	__m256i c = _mm256_loadu_si256( (const __m256i*)state[ 2 ] );
+	__m256i d = _mm256_loadu_si256( (const __m256i*)state[ 3 ] );
+	__m256i e = _mm256_loadu_si256( (const __m256i*)state[ 4 ] );
+	__m256i f = _mm256_loadu_si256( (const __m256i*)state[ 5 ] );
+	__m256i g = _mm256_loadu_si256( (const __m256i*)state[ 6 ] );
+	__m256i h = _mm256_loadu_si256( (const __m256i*)state[ 7 ] );
+
+	for( int t = 0; t < 64; ++t )
+	{
+		if( t >= 16 )
+		{
+			__m256i w15 = W[ (t - 15) & 0x0F ];
+			__m256i w2 = W[ (t - 2) & 0x0F ];
+			__m256i s0 = xor3( rotr( w15, 7 ), rotr( w15, 18 ), _mm256_srli_epi32( w15, 3 ) );
+			__m256i s1 = xor3( rotr( w2, 17 ), rotr( w2, 19 ), _mm256_srli_epi32( w2, 10 ) );
+			W[ t & 0x0F ] = add( add( W[ t & 0x0F ], W[ (t - 7) & 0x0F ] ), add( s0, s1 ) );
+		}
+
+		__m256i ch = _mm256_xor_si256( _mm256_and_si256( e, f ), _mm256_andnot_si256( e, g ) );
+		__m256i t1 = add( add( h, xor3( rotr( e, 6 ), rotr( e, 11 ), rotr( e, 25 ) ) ),
+			add( ch, add( _mm256_set1_epi32( (int)SHA256_CONST[ t ] ), W[ t & 0x0F ] ) ) );
+		__m256i maj = _mm256_or_si256( _mm256_and_si256( a, b ), _mm256_and_si256( c, _mm256_or_si256( a, b ) ) );
+		__m256i t2 = add( xor3( rotr( a, 2 ), rotr( a, 13 ), rotr( a, 22 ) ), maj );
+
+		h = g;
+		g = f;
+		f = e;
+		e = add( d, t1 );
+		d = c;
+		c = b;
+		b = a;
+		a = add( t1, t2 );
+	}
+
+	__m256i* s = (__m256i*)state;
+	_mm256_storeu_si256( s + 0, add( _mm256_loadu_si256( s + 0 ), a ) );
+	_mm256_storeu_si256( s + 1, add( _mm256_loadu_si256( s + 1 ), b ) );
+	_mm256_storeu_si256( s + 2, add( _mm256_loadu_si256( s + 2 ), c ) );
+	_mm256_storeu_si256( s + 3, add( _mm256_loadu_si256( s + 3 ), d ) );
+	_mm256_storeu_si256( s + 4, add( _mm256_loadu_si256( s + 4 ), e ) );
+	_mm256_storeu_si256( s + 5, add( _mm256_loadu_si256( s + 5 ), f ) );
+	_mm256_storeu_si256( s + 6, add( _mm256_loadu_si256( s + 6 ), g ) );
+	_mm256_storeu_si256( s + 7, add( _mm256_loadu_si256( s + 7 ), h ) );
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+/// Hashes up to 8 messages in parallel lanes.
+/// Lanes go in lockstep; lane with shorter message processes zero blocks after its end, its result is taken earlier.
+void sha256x8( const uint8_t* const data[], const size_t lengths[], size_t count, uint8_t* hashes )
+{
+	static const uint8_t zeroBlock[ 64 ] = { 0 };
+
+	uint32_t state[ 8 ][ 8 ];
+	for( int w = 0; w < 8; ++w )
+		for( int lane = 0; lane < 8; ++lane )
+			state[ w ][ lane ] = SHA256_IV[ w ];
+
+	size_t fullBlocks[ 8 ] = { 0 };
+	size_t totalBlocks[ 8 ] = { 0 };
+	uint8_t tails[ 8 ][ 128 ];
+	size_t maxBlocks = 0;
+
+	for( size_t lane = 0; lane < count; ++lane )
+	{
+		size_t len = lengths[ lane ];
+		size_t rem = len & 0x3F;
+		fullBlocks[ lane ] = len >> 6;
+		size_t tailBlocks = (rem + 9 > 64) ? 2 : 1;
+		totalBlocks[ lane ] = fullBlocks[ lane ] + tailBlocks;
+		if( totalBlocks[ lane ] > maxBlocks )
+			maxBlocks = totalBlocks[ lane ];
+
+		// Padding: 0x80, zeroes, length in bits (BigEndian)
+		uint8_t* tail = tails[ lane ];
+		memset( tail, 0, sizeof(tails[ lane ]) );
+		if( rem != 0 )
+			memcpy( tail, data[ lane ] + (len - rem), rem );
+		tail[ rem ] = 0x80;
+		uint64_t bits = (uint64_t)len << 3;
+		uint8_t* end = tail + tailBlocks * 64;
+		for( int i = 1; i <= 8; ++i, bits >>= 8 )
+			end[ -i ] = (uint8_t)bits;
+	}
+
+	const uint8_t* blocks[ 8 ];
+	for( size_t j = 0; j < maxBlocks; ++j )
+	{
+		for( size_t lane = 0; lane < 8; ++lane )
+		{
+			if( j < fullBlocks[ lane ] )
+				blocks[ lane ] = data[ lane ] + (j << 6);
+			else if( j < totalBlocks[ lane ] )
+				blocks[ lane ] = tails[ lane ] + ((j - fullBlocks[ lane ]) << 6);
+			else
+				blocks[ lane ] = zeroBlock;
+		}
+
+		sha256_transform_x8_avx2( state, blocks );
+
+		for( size_t lane = 0; lane < count; ++lane )
+		{
+			if( totalBlocks[ lane ] != j + 1 )
+				continue;
+
+			uint8_t* hash = hashes + lane * HASH_SIZE_SHA256;
+			for( int w = 0; w < 8; ++w )
+			{
+				uint32_t v = state[ w ][ lane ];
+				hash[ 4 * w ]     = (uint8_t)(v >> 24);
+				hash[ 4 * w + 1 ] = (uint8_t)(v >> 16);
+				hash[ 4 * w + 2 ] = (uint8_t)(v >> 8);
+				hash[ 4 * w + 3 ] = (uint8_t)v;
+			}
+		}
+	}
+}
+
+#endif // DENOM_X86
+
+// =====================================================================================================================
+// Self test
+// =====================================================================================================================
+
+struct TestVector
+{
+	const char* msg;
+	const char* hash;
+};
+
+const TestVector SHA256_VECTORS[] = {
+	{ "", "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855" },
+	{ "abc", "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad" },
+	{ "abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq",
+		"248d6a61d20638b8e5c026930c3e6039a33ce45964ff2167f6ecedd419db06c1" },
+	{ "abcdefghbcdefghicdefghijdefghijkefghijklfghijklmghijklmnhijklmnoijklmnopjklmnopqklmnopqrlmnopqrsmnopqrstnopqrstu",
+		"cf5b16a778af8380036ce59e7b0492370b249b11e8f07a51afac45037afee9d1" }
+};
+
+// ---------------------------------------------------------------------------------------------------------------------
+bool checkTransform( FUNCT_TRANSFORM* transform )
+{
+	for( const TestVector& v : SHA256_VECTORS )
+	{
+		SHA256_CTX ctx;
+		sha256_init( &ctx );
+		ctx.transform = transform;
+		sha_update( &ctx, (const uint8_t*)v.msg, strlen( v.msg ) );
+		sha_final( &ctx );
+		if( Binary( ctx.data, ctx.data + HASH_SIZE_SHA256 ) != Binary( v.hash ) )
+			return false;
+	}
+
+	// 1 000 000 of 'a', by parts of different sizes
+	std::vector<uint8_t> million( 1000000, 'a' );
+	SHA256_CTX ctx;
+	sha256_init( &ctx );
+	ctx.transform = transform;
+	size_t part = 1;
+	for( size_t offset = 0; offset < million.size(); offset += part, part = part * 3 + 1 )
+		sha_update( &ctx, million.data() + offset, std::min( part, million.size() - offset ) );
+	sha_final( &ctx );
+	return Binary( ctx.data, ctx.data + HASH_SIZE_SHA256 )
+		== Binary( "cdc76e5c9914fb9281a1c7e284d73e67f1809a48a497200e046d39ccc7112cd0" );
+}
+
+} // namespace
+
+// =====================================================================================================================
+
+// ---------------------------------------------------------------------------------------------------------------------
+FUNCT_TRANSFORM* sha256_best_transform()
+{
+	#ifdef DENOM_X86
+		if( cpuFeatures().shaNi )
+			return sha256_transform_shani;
+	#endif
+	return sha256_transform;
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+void calcHashSHA256Multi( const uint8_t* const data[], const size_t lengths[], size_t count, uint8_t* hashes )
+{
+	TraceSpan span( "calcHashSHA256Multi" );
+	size_t i = 0;
+	#ifdef DENOM_X86
+		// SHA-NI processes one message faster than AVX2 lanes process 8
+		if( cpuFeatures().avx2 && !cpuFeatures().shaNi )
+		{
+			for( ; (count - i) >= 2; i += 8 )
+			{
+				size_t n = std::min( count - i, (size_t)8 );
+				sha256x8( data + i, lengths + i, n, hashes + i * HASH_SIZE_SHA256 );
+
+				static Counter& bytesHashed = Metrics::counter( "hash.bytesHashed" );
+				for( size_t k = 0; k < n; ++k )
+					bytesHashed.add( lengths[ i + k ] );
+				if( n < 8 )
+				{
+					i += n;
+					break;
+				}
+			}
+		}
+	#endif
+
+	for( ; i < count; ++i )
+		calcHashSHA256( data[ i ], lengths[ i ], hashes + i * HASH_SIZE_SHA256 );
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+string sha256ImplName()
+{
+	string name;
+	#ifdef DENOM_X86
+		name = cpuFeatures().shaNi ? "SHA-NI" : "portable";
+		if( cpuFeatures().avx2 )
+			name += ", AVX2 x8";
+	#else
+		name = "portable";
+	#endif
+	return name;
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+bool sha256SelfTest()
+{
+	if( !checkTransform( sha256_transform ) )
+		return false;
+
+	#ifdef DENOM_X86
+		if( cpuFeatures().shaNi && !checkTransform( sha256_transform_shani ) )
+			return false;
+	#endif
+
+	// Messages of different lengths, including padding into 1 or 2 blocks, through multi-message path
+	// (AVX2 lanes, if CPU has AVX2) against hash of each message by verified transform
+	std::vector<Binary> msgs;
+	for( const TestVector& v : SHA256_VECTORS )
+		msgs.push_back( Binary( (const uint8_t*)v.msg, (const uint8_t*)v.msg + strlen( v.msg ) ) );
+	const size_t lens[] = { 55, 56, 63, 64, 65, 1000, 7, 119, 120, 128, 0 };
+	for( size_t len : lens )
+		msgs.push_back( Binary( len, (uint8_t)(len * 7 + 1) ) );
+
+	std::vector<const uint8_t*> data;
+	std::vector<size_t> lengths;
+	for( const Binary& m : msgs )
+	{
+		data.push_back( m.data() );
+		lengths.push_back( m.size() );
+	}
+
+	// Every count of messages in the last group of 8
+	for( size_t count = 1; count <= msgs.size(); ++count )
+	{
+		Binary hashes( count * HASH_SIZE_SHA256 );
+		calcHashSHA256Multi( data.data(), lengths.data(), count, hashes.data() );
+		for( size_t i = 0; i < count; ++i )
+		{
+			Binary expected( HASH_SIZE_SHA256 );
+			calcHashSHA256( data[ i ], lengths[ i ], expected.data() );
+			if( hashes.slice( i * HASH_SIZE_SHA256, HASH_SIZE_SHA256 ) != expected )
+				return false;
+		}
+	}
+
+	#ifdef DENOM_X86
+		// With SHA-NI multi-message path does not use AVX2 lanes - check them directly
+		if( cpuFeatures().avx2 )
+		{
+			for( size_t offset = 0; offset < msgs.size(); offset += 8 )
+			{
+				size_t n = std::min( msgs.size() - offset, (size_t)8 );
+				Binary hashes( n * HASH_SIZE_SHA256 );
+				sha256x8( data.data() + offset, lengths.data() + offset, n, hashes.data() );
+				for( size_t i = 0; i < n; ++i )
+				{
+					Binary expected( HASH_SIZE_SHA256 );
+					calcHashSHA256( data[ offset + i ], lengths[ offset + i ], expected.data() );
+					if( hashes.slice( i * HASH_SIZE_SHA256, HASH_SIZE_SHA256 ) != expected )
+						return false;
+				}
+			}
+		}
+	#endif
+
+	return true;
+}
+
+} // namespace Denom
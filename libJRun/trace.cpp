@@ -0,0 +1,171 @@
+/// Denom.org
+///
+/// MIT No Attribution.
+///
+/// Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software
+/// without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+/// permit persons to whom the Software is furnished to do so.
+///
+/// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+/// PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+/// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+///
+/// Author:  Sergey Novochenko,  Digrol@gmail.com
+///
+/// Tracing of time spans, output in Chrome trace event format.
+
+#include "stdinc.h"
+
+#include "trace.h"
+#include "files.h"
+#include "format.h"
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#ifdef _WIN32
+	#include <process.h>
+	#define getpid _getpid
+#else
+	#include <unistd.h>
+#endif
+
+namespace {
+
+const size_t EVENTS_PER_THREAD = 1 << 16;
+
+struct Event
+{
+	const char* name;
+	int64_t beginNs;
+	int64_t endNs;
+};
+
+// ---------------------------------------------------------------------------------------------------------------------
+/// Events of one thread. Only owner thread writes; 'count' is published with release, so 'finish' can read
+/// events while thread still works.
+struct ThreadBuffer
+{
+	std::unique_ptr<Event[]> events{ new Event[ EVENTS_PER_THREAD ] };
+	std::atomic<size_t> count{ 0 };
+	std::atomic<size_t> dropped{ 0 };
+	uint32_t threadId = 0;
+};
+
+// ---------------------------------------------------------------------------------------------------------------------
+struct Tracer
+{
+	std::mutex mutex;
+	std::wstring filename;
+	int64_t startNs = 0;
+	// Buffers are never freed: threads keep pointers to them
+	std::vector< std::unique_ptr<ThreadBuffer> > buffers;
+};
+
+// ---------------------------------------------------------------------------------------------------------------------
+Tracer& tracer()
+{
+	static Tracer instance;
+	return instance;
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+/// Buffer of current thread, created by the first span of thread.
+ThreadBuffer& threadBuffer()
+{
+	thread_local ThreadBuffer* buffer = nullptr;
+	if( buffer == nullptr )
+	{
+		Tracer& t = tracer();
+		std::lock_guard<std::mutex> lock( t.mutex );
+		t.buffers.emplace_back( new ThreadBuffer() );
+		buffer = t.buffers.back().get();
+		buffer->threadId = (uint32_t)t.buffers.size();
+	}
+	return *buffer;
+}
+
+} // namespace
+
+namespace Denom {
+
+std::atomic<bool> Trace::enabled( false );
+
+// ---------------------------------------------------------------------------------------------------------------------
+int64_t Trace::now()
+{
+	using namespace std::chrono;
+	return duration_cast<nanoseconds>( steady_clock::now().time_since_epoch() ).count();
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+void Trace::start( const std::wstring& filename )
+{
+	Tracer& t = tracer();
+	{
+		std::lock_guard<std::mutex> lock( t.mutex );
+		t.filename = filename;
+		t.startNs = now();
+	}
+	enabled.store( true, std::memory_order_relaxed );
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+void Trace::record( const char* name, int64_t beginNs, int64_t endNs )
+{
+	ThreadBuffer& buf = threadBuffer();
+	size_t index = buf.count.load( std::memory_order_relaxed );
+	if( index == EVENTS_PER_THREAD )
+	{
+		buf.dropped.fetch_add( 1, std::memory_order_relaxed );
+		return;
+	}
+	buf.events[ index ] = Event{ name, beginNs, endNs };
+	buf.count.store( index + 1, std::memory_order_release );
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+void Trace::finish()
+{
+	if( !enabled.exchange( false ) )
+		return;
+
+	Tracer& t = tracer();
+	std::string json;
+	std::wstring filename;
+	{
+		std::lock_guard<std::mutex> lock( t.mutex );
+		filename = t.filename;
+		int pid = (int)getpid();
+
+		// Complete events ("ph":"X"), times in microseconds from 'start'
+		json = "{\"traceEvents\":[\n";
+		const char* separator = "";
+		for( const std::unique_ptr<ThreadBuffer>& buf : t.buffers )
+		{
+			size_t count = buf->count.load( std::memory_order_acquire );
+			for( size_t i = 0; i < count; ++i )
+			{
+				const Event& e = buf->events[ i ];
+				formatTo( json, FMT( "{}{{\"name\":\"{}\",\"ph\":\"X\",\"ts\":{},\"dur\":{},\"pid\":{},\"tid\":{}}}" ),
+					separator, e.name, (double)(e.beginNs - t.startNs) / 1000, (double)(e.endNs - e.beginNs) / 1000,
+					pid, buf->threadId );
+				separator = ",\n";
+			}
+
+			size_t dropped = buf->dropped.load( std::memory_order_relaxed );
+			if( dropped != 0 )
+			{
+				formatTo( json, FMT( "{}{{\"name\":\"dropped {} spans\",\"ph\":\"i\",\"s\":\"t\",\"ts\":0,\"pid\":{},\"tid\":{}}}" ),
+					separator, dropped, pid, buf->threadId );
+				separator = ",\n";
+			}
+		}
+		json += "\n],\"displayTimeUnit\":\"ms\"}\n";
+	}
+
+	writeFileAtomic( filename, (const uint8_t*)json.data(), json.size() );
+}
+
+} // namespace Denom
@@ -0,0 +1,85 @@
+/// Denom.org
+///
+/// MIT No Attribution.
+///
+/// Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software
+/// without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+/// permit persons to whom the Software is furnished to do so.
+///
+/// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+/// PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+/// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+///
+/// Author:  Sergey Novochenko,  Digrol@gmail.com
+///
+/// Tracing of time spans, output in Chrome trace event format.
+
+#ifndef TRACE_H_E1947C2B0D5A63F8
+#define TRACE_H_E1947C2B0D5A63F8
+
+#include <stdint.h>
+#include <atomic>
+#include <string>
+
+namespace Denom {
+
+// ---------------------------------------------------------------------------------------------------------------------
+/// Collects spans (name, begin, end) while tracing is on, and writes them as JSON, which can be opened in
+/// chrome://tracing or ui.perfetto.dev.
+/// Each thread writes spans to its own preallocated buffer without locks; spans beyond buffer capacity are dropped.
+/// When tracing is off, span costs one relaxed atomic load.
+class Trace
+{
+public:
+	/// Start collecting spans, they will be written to 'filename' by 'finish'.
+	static void start( const std::wstring& filename );
+
+	/// Stop collecting and write collected spans to file. Does nothing if tracing was not started.
+	/// Called once, at the end of process.
+	static void finish();
+
+	static bool isEnabled()
+	{
+		return enabled.load( std::memory_order_relaxed );
+	}
+
+	/// Monotonic time in nanoseconds.
+	static int64_t now();
+
+	/// @param name - string literal.
+	static void record( const char* name, int64_t beginNs, int64_t endNs );
+
+private:
+	static std::atomic<bool> enabled;
+};
+
+// ---------------------------------------------------------------------------------------------------------------------
+/// Records time of its life as a span.
+/// Example:
+///     {
+///         TraceSpan span( "compile" );
+///         compile();
+///     }
+class TraceSpan
+{
+public:
+	/// @param name - string literal, it is stored by pointer.
+	explicit TraceSpan( const char* name ) : name( name ), beginNs( Trace::isEnabled() ? Trace::now() : -1 ) {}
+
+	~TraceSpan()
+	{
+		if( beginNs >= 0 )
+			Trace::record( name, beginNs, Trace::now() );
+	}
+
+	TraceSpan( const TraceSpan& ) = delete;
+	TraceSpan& operator=( const TraceSpan& ) = delete;
+
+private:
+	const char* name;
+	int64_t beginNs;
+};
+
+} // namespace Denom
+
+#endif // Header guard
@@ -0,0 +1,273 @@
+/// Denom.org
+///
+/// MIT No Attribution.
+///
+/// Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software
+/// without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+/// permit persons to whom the Software is furnished to do so.
+///
+/// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+/// PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+/// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+///
+/// Author:  Sergey Novochenko,  Digrol@gmail.com
+///
+/// Conversion between UTF-8 and wide strings (UTF-32 on Linux, UTF-16 on Windows).
+
+#include "stdinc.h"
+
+#include "utf8.h"
+#include <stdint.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+	#define DENOM_SSE2
+	#include <emmintrin.h>
+#endif
+
+namespace {
+
+const uint32_t REPLACEMENT_CHAR = 0xFFFD;
+const bool WIDE_IS_UTF16 = sizeof(wchar_t) == 2;
+
+// ---------------------------------------------------------------------------------------------------------------------
+/// Copies ASCII prefix of 'src' to 'dst', 16 characters per step.
+/// @return - number of copied characters.
+size_t asciiToWide( const uint8_t* src, size_t size, wchar_t* dst )
+{
+	size_t i = 0;
+
+	#ifdef DENOM_SSE2
+		const __m128i zero = _mm_setzero_si128();
+		for( ; i + 16 <= size; i += 16 )
+		{
+			__m128i bytes = _mm_loadu_si128( (const __m128i*)(src + i) );
+			if( _mm_movemask_epi8( bytes ) != 0 )
+				break;
+
+			__m128i lo = _mm_unpacklo_epi8( bytes, zero );
+			__m128i hi = _mm_unpackhi_epi8( bytes, zero );
+			if constexpr( WIDE_IS_UTF16 )
+			{
+				_mm_storeu_si128( (__m128i*)(dst + i), lo );
+				_mm_storeu_si128( (__m128i*)(dst + i + 8), hi );
+			}
+			else
+			{
+				_mm_storeu_si128( (__m128i*)(dst + i), _mm_unpacklo_epi16( lo, zero ) );
+				_mm_storeu_si128( (__m128i*)(dst + i + 4), _mm_unpackhi_epi16( lo, zero ) );
+				_mm_storeu_si128( (__m128i*)(dst + i + 8), _mm_unpacklo_epi16( hi, zero ) );
+				_mm_storeu_si128( (__m128i*)(dst + i + 12), _mm_unpackhi_epi16( hi, zero ) );
+			}
+		}
+	#endif
+
+	for( ; (i < size) && (src[ i ] < 0x80); ++i )
+	{
+		dst[ i ] = (wchar_t)src[ i ];
+	}
+	return i;
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+/// Copies ASCII prefix of 'src' to 'dst', 16 characters per step.
+/// @return - number of copied characters.
+size_t asciiToUtf8( const wchar_t* src, size_t size, uint8_t* dst )
+{
+	size_t i = 0;
+
+	#ifdef DENOM_SSE2
+		const __m128i zero = _mm_setzero_si128();
+		for( ; i + 16 <= size; i += 16 )
+		{
+			const __m128i* p = (const __m128i*)(src + i);
+			__m128i bytes;
+			if constexpr( WIDE_IS_UTF16 )
+			{
+				__m128i v0 = _mm_loadu_si128( p );
+				__m128i v1 = _mm_loadu_si128( p + 1 );
+				__m128i high = _mm_and_si128( _mm_or_si128( v0, v1 ), _mm_set1_epi16( (short)0xFF80 ) );
+				if( _mm_movemask_epi8( _mm_cmpeq_epi16( high, zero ) ) != 0xFFFF )
+					break;
+				bytes = _mm_packus_epi16( v0, v1 );
+			}
+			else
+			{
+				__m128i v0 = _mm_loadu_si128( p );
+				__m128i v1 = _mm_loadu_si128( p + 1 );
+				__m128i v2 = _mm_loadu_si128( p + 2 );
+				__m128i v3 = _mm_loadu_si128( p + 3 );
+				__m128i all = _mm_or_si128( _mm_or_si128( v0, v1 ), _mm_or_si128( v2, v3 ) );
+				__m128i high = _mm_and_si128( all, _mm_set1_epi32( (int)0xFFFFFF80 ) );
+				if( _mm_movemask_epi8( _mm_cmpeq_epi32( high, zero ) ) != 0xFFFF )
+					break;
+				bytes = _mm_packus_epi16( _mm_packs_epi32( v0, v1 ), _mm_packs_epi32( v2, v3 ) );
+			}
+			_mm_storeu_si128( (__m128i*)(dst + i), bytes );
+		}
+	#endif
+
+	for( ; (i < size) && ((uint32_t)src[ i ] < 0x80); ++i )
+	{
+		dst[ i ] = (uint8_t)src[ i ];
+	}
+	return i;
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+/// Decodes one non-ASCII sequence, 'size' > 0.
+/// @param codePoint - decoded character or REPLACEMENT_CHAR.
+/// @return - number of consumed bytes; for invalid sequence - bytes up to the first wrong one.
+size_t decodeUtf8( const uint8_t* src, size_t size, uint32_t& codePoint, bool& valid )
+{
+	uint8_t lead = src[ 0 ];
+	size_t len;
+	uint32_t minCodePoint;
+	if( (lead >= 0xC2) && (lead <= 0xDF) )
+	{
+		len = 2;
+		codePoint = lead & 0x1F;
+		minCodePoint = 0x80;
+	}
+	else if( (lead & 0xF0) == 0xE0 )
+	{
+		len = 3;
+		codePoint = lead & 0x0F;
+		minCodePoint = 0x800;
+	}
+	else if( (lead >= 0xF0) && (lead <= 0xF4) )
+	{
+		len = 4;
+		codePoint = lead & 0x07;
+		minCodePoint = 0x10000;
+	}
+	else
+	{
+		codePoint = REPLACEMENT_CHAR;
+		valid = false;
+		return 1;
+	}
+
+	for( size_t k = 1; k < len; ++k )
+	{
+		if( (k >= size) || ((src[ k ] & 0xC0) != 0x80) )
+		{
+			codePoint = REPLACEMENT_CHAR;
+			valid = false;
+			return k;
+		}
+		codePoint = (codePoint << 6) | (src[ k ] & 0x3F);
+	}
+
+	if( (codePoint < minCodePoint) || (codePoint > 0x10FFFF) || ((codePoint >= 0xD800) && (codePoint <= 0xDFFF)) )
+	{
+		codePoint = REPLACEMENT_CHAR;
+		valid = false;
+	}
+	return len;
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+/// @return - number of written bytes, 1..4.
+size_t encodeUtf8( uint32_t codePoint, uint8_t* dst )
+{
+	if( codePoint < 0x80 )
+	{
+		dst[ 0 ] = (uint8_t)codePoint;
+		return 1;
+	}
+	if( codePoint < 0x800 )
+	{
+		dst[ 0 ] = (uint8_t)(0xC0 | (codePoint >> 6));
+		dst[ 1 ] = (uint8_t)(0x80 | (codePoint & 0x3F));
+		return 2;
+	}
+	if( codePoint < 0x10000 )
+	{
+		dst[ 0 ] = (uint8_t)(0xE0 | (codePoint >> 12));
+		dst[ 1 ] = (uint8_t)(0x80 | ((codePoint >> 6) & 0x3F));
+		dst[ 2 ] = (uint8_t)(0x80 | (codePoint & 0x3F));
+		return 3;
+	}
+	dst[ 0 ] = (uint8_t)(0xF0 | (codePoint >> 18));
+	dst[ 1 ] = (uint8_t)(0x80 | ((codePoint >> 12) & 0x3F));
+	dst[ 2 ] = (uint8_t)(0x80 | ((codePoint >> 6) & 0x3F));
+	dst[ 3 ] = (uint8_t)(0x80 | (codePoint & 0x3F));
+	return 4;
+}
+
+} // namespace
+
+namespace Denom {
+
+// ---------------------------------------------------------------------------------------------------------------------
+bool utf8ToWide( const char* src, size_t size, std::wstring& dst )
+{
+	// One wide character per byte is enough, also for surrogate pairs (4 bytes -> 2 characters)
+	dst.resize( size );
+	const uint8_t* in = (const uint8_t*)src;
+	wchar_t* out = &dst[ 0 ];
+	bool valid = true;
+
+	size_t i = 0;
+	size_t o = 0;
+	while( i < size )
+	{
+		size_t ascii = asciiToWide( in + i, size - i, out + o );
+		i += ascii;
+		o += ascii;
+		if( i == size )
+			break;
+
+		uint32_t codePoint;
+		i += decodeUtf8( in + i, size - i, codePoint, valid );
+		if( WIDE_IS_UTF16 && (codePoint >= 0x10000) )
+		{
+			codePoint -= 0x10000;
+			out[ o++ ] = (wchar_t)(0xD800 | (codePoint >> 10));
+			out[ o++ ] = (wchar_t)(0xDC00 | (codePoint & 0x3FF));
+		}
+		else
+		{
+			out[ o++ ] = (wchar_t)codePoint;
+		}
+	}
+	dst.resize( o );
+	return valid;
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+bool wideToUtf8( const wchar_t* src, size_t size, std::string& dst )
+{
+	// UTF-16: up to 3 bytes per character (pair of surrogates - 4 bytes). UTF-32: up to 4 bytes.
+	dst.resize( size * (WIDE_IS_UTF16 ? 3 : 4) );
+	uint8_t* out = (uint8_t*)&dst[ 0 ];
+	bool valid = true;
+
+	size_t i = 0;
+	size_t o = 0;
+	while( i < size )
+	{
+		size_t ascii = asciiToUtf8( src + i, size - i, out + o );
+		i += ascii;
+		o += ascii;
+		if( i == size )
+			break;
+
+		uint32_t codePoint = (uint32_t)src[ i++ ];
+		if( WIDE_IS_UTF16 && (codePoint >= 0xD800) && (codePoint <= 0xDBFF) && (i < size) &&
+			((uint32_t)src[ i ] >= 0xDC00) && ((uint32_t)src[ i ] <= 0xDFFF) )
+		{
+			codePoint = 0x10000 + ((codePoint - 0xD800) << 10) + ((uint32_t)src[ i++ ] - 0xDC00);
+		}
+		else if( ((codePoint >= 0xD800) && (codePoint <= 0xDFFF)) || (codePoint > 0x10FFFF) )
+		{
+			codePoint = REPLACEMENT_CHAR;
+			valid = false;
+		}
+		o += encodeUtf8( codePoint, out + o );
+	}
+	dst.resize( o );
+	return valid;
+}
+
+} // namespace Denom
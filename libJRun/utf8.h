@@ -0,0 +1,36 @@
+/// Denom.org
+///
+/// MIT No Attribution.
+///
+/// Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software
+/// without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+/// permit persons to whom the Software is furnished to do so.
+///
+/// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+/// PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+/// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+///
+/// Author:  Sergey Novochenko,  Digrol@gmail.com
+///
+/// Conversion between UTF-8 and wide strings (UTF-32 on Linux, UTF-16 on Windows).
+
+#ifndef UTF8_H_47D1A9C03E6B2F85
+#define UTF8_H_47D1A9C03E6B2F85
+
+#include <stddef.h>
+#include <string>
+
+namespace Denom {
+
+// ---------------------------------------------------------------------------------------------------------------------
+/// Validating transcoders without locale machinery.
+/// ASCII parts of text are converted by 16 characters per step (SSE2).
+/// Invalid sequences (overlong forms, surrogates, code points above U+10FFFF, broken bytes) are replaced with U+FFFD.
+/// 'dst' is overwritten, its memory is reused - keep one buffer to convert many strings without allocations.
+/// @return false if 'src' contained invalid sequences.
+bool utf8ToWide( const char* src, size_t size, std::wstring& dst );
+bool wideToUtf8( const wchar_t* src, size_t size, std::string& dst );
+
+} // namespace Denom
+
+#endif // Header guard
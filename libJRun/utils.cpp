@@ -18,11 +18,20 @@
 
 #include <chrono>
 #include <thread>
-#include <locale>
-#include <codecvt>
 
 #include "utils.h"
 #include "exception.h"
+#include "random.h"
+#include "cpu.h"
+#include "utf8.h"
+
+#ifdef DENOM_X86
+	#ifdef _MSC_VER
+		#include <intrin.h>
+	#else
+		#include <x86intrin.h>
+	#endif
+#endif
 
 #ifdef _WIN32
 #include <windows.h>
@@ -66,6 +75,23 @@ vector< wstring > convertCommandLine( int argc, char* argv[] )
 	return params;
 }
 
+// ---------------------------------------------------------------------------------------------------------------------
+vector< string > convertCommandLineUtf8( int argc, char* argv[] )
+{
+	vector< string > params;
+	params.reserve( argc );
+
+	for( int i = 0; i < argc; ++i )
+	{
+		#ifdef _WIN32
+			params.push_back( w2s( strToWstring( argv[ i ] ) ) );
+		#else
+			params.push_back( argv[ i ] );
+		#endif // _WIN32
+	}
+	return params;
+}
+
 
 // ---------------------------------------------------------------------------------------------------------------------
 void sleep( uint32_t milliSec )
@@ -77,10 +103,7 @@ void sleep( uint32_t milliSec )
 uint32_t RangedRand( uint32_t rangeMin, uint32_t rangeMax )
 {
 	MUST_M( rangeMin < rangeMax, L"Wrong random range" );
-	uint16_t hi = rand() + rand() + rand();
-	uint16_t lo = rand() + rand() + rand();
-	uint64_t num = ((uint32_t)hi << 16) | lo;
-	return (uint32_t)(int64_t( num * ((int64_t)rangeMax - (int64_t)rangeMin + 1) / (0xFFFFFFFFLL + 1) ) + (int64_t)rangeMin);
+	return Random::local().range( rangeMin, rangeMax );
 }
 
 // =====================================================================================================================
@@ -88,63 +111,209 @@ uint32_t RangedRand( uint32_t rangeMin, uint32_t rangeMax )
 // =====================================================================================================================
 
 // ---------------------------------------------------------------------------------------------------------------------
-static int64_t getTicks()
+static int64_t getMonotonicTicks()
+{
+	#ifdef _WIN32
+		LARGE_INTEGER ticks;
+		QueryPerformanceCounter( &ticks );
+		return ticks.QuadPart;
+	#else
+		timespec ts;
+		clock_gettime( CLOCK_MONOTONIC, &ts );
+		return (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+	#endif
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+static int64_t getMonotonicFrequency()
 {
-	return 0;
-// 	LARGE_INTEGER ticks;
-// 	QueryPerformanceCounter( &ticks );
-// 	return ticks.QuadPart;
+	#ifdef _WIN32
+		LARGE_INTEGER freq;
+		QueryPerformanceFrequency( &freq );
+		return freq.QuadPart;
+	#else
+		return 1000000000;
+	#endif
 }
 
+#ifdef DENOM_X86
 // ---------------------------------------------------------------------------------------------------------------------
-static int64_t getFrequency()
+static int64_t getTscTicks()
 {
-	return 0;
-	// 	LARGE_INTEGER i;
-// 	QueryPerformanceFrequency( &i );
-// 	return i.QuadPart;
+	return (int64_t)__rdtsc();
 }
 
 // ---------------------------------------------------------------------------------------------------------------------
-Ticker::Ticker()
+/// TSC frequency, measured once against monotonic clock for 10 ms.
+static int64_t getTscFrequency()
 {
-	frequency = getFrequency();
-	startTicks = getTicks();
+	static const int64_t frequency = []
+	{
+		int64_t monoFreq = getMonotonicFrequency();
+		int64_t mono0 = getMonotonicTicks();
+		int64_t tsc0 = getTscTicks();
+		std::this_thread::sleep_for( std::chrono::milliseconds( 10 ) );
+		int64_t mono1 = getMonotonicTicks();
+		int64_t tsc1 = getTscTicks();
+		return (int64_t)((double)(tsc1 - tsc0) * (double)monoFreq / (double)(mono1 - mono0));
+	}();
+	return frequency;
+}
+#endif // DENOM_X86
+
+// ---------------------------------------------------------------------------------------------------------------------
+/// Convert ticks to units ('unitsPerSecond'), without overflow for long intervals.
+static int64_t ticksToUnits( int64_t ticks, int64_t frequency, int64_t unitsPerSecond )
+{
+	return (ticks / frequency) * unitsPerSecond + (ticks % frequency) * unitsPerSecond / frequency;
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+Ticker::Ticker( bool useTsc )
+{
+	#ifdef DENOM_X86
+		tsc = useTsc && cpuFeatures().invariantTsc;
+		frequency = tsc ? getTscFrequency() : getMonotonicFrequency();
+	#else
+		(void)useTsc;
+		tsc = false;
+		frequency = getMonotonicFrequency();
+	#endif
+	startTicks = ticks();
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+int64_t Ticker::ticks() const
+{
+	#ifdef DENOM_X86
+		if( tsc )
+			return getTscTicks();
+	#endif
+	return getMonotonicTicks();
 }
 
 // ---------------------------------------------------------------------------------------------------------------------
 void Ticker::restart()
 {
-	startTicks = getTicks();
+	startTicks = ticks();
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+int64_t Ticker::diff() const
+{
+	return ticks() - startTicks;
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+int64_t Ticker::diffMs() const
+{
+	return ticksToUnits( diff(), frequency, 1000 );
 }
 
 // ---------------------------------------------------------------------------------------------------------------------
-int64_t Ticker::diff()
+int64_t Ticker::diffUs() const
 {
-	return getTicks() - startTicks;
+	return ticksToUnits( diff(), frequency, 1000000 );
 }
 
 // ---------------------------------------------------------------------------------------------------------------------
-int64_t Ticker::diffMs()
+int64_t Ticker::diffNs() const
 {
-	return diff() * 1000 / frequency;
+	return ticksToUnits( diff(), frequency, 1000000000 );
 }
+
 // =====================================================================================================================
 // } Ticker
 // =====================================================================================================================
 
 // ---------------------------------------------------------------------------------------------------------------------
-wstring s2w( const string& str )
+wstring s2w( std::string_view str )
+{
+	wstring res;
+	utf8ToWide( str.data(), str.size(), res );
+	return res;
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+void s2w( std::string_view str, wstring& out )
+{
+	utf8ToWide( str.data(), str.size(), out );
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+string w2s( std::wstring_view wstr )
+{
+	string res;
+	wideToUtf8( wstr.data(), wstr.size(), res );
+	return res;
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+void w2s( std::wstring_view wstr, string& out )
+{
+	wideToUtf8( wstr.data(), wstr.size(), out );
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+std::filesystem::path toPath( const wstring& filename )
+{
+	#ifdef _WIN32
+		return std::filesystem::path( filename );
+	#else
+		return std::filesystem::path( w2s( filename ) );
+	#endif
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+wstring fromPath( const std::filesystem::path& path )
+{
+	#ifdef _WIN32
+		return path.wstring();
+	#else
+		return s2w( path.string() );
+	#endif
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+NativeName toNative( const wstring& filename )
+{
+	#ifdef _WIN32
+		return filename;
+	#else
+		return w2s( filename );
+	#endif
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+NativeName toNative( std::string_view utf8Filename )
+{
+	#ifdef _WIN32
+		return s2w( utf8Filename );
+	#else
+		return NativeName( utf8Filename );
+	#endif
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+wstring fromNative( const NativeName& filename )
 {
-	std::wstring_convert<std::codecvt_utf8<wchar_t>> converter;
-	return converter.from_bytes( str );
+	#ifdef _WIN32
+		return filename;
+	#else
+		return s2w( filename );
+	#endif
 }
 
 // ---------------------------------------------------------------------------------------------------------------------
-string w2s( const wstring& wstr )
+wstring getEnv( const wstring& name )
 {
-	std::wstring_convert<std::codecvt_utf8<wchar_t>> converter;
-	return converter.to_bytes( wstr );
+	#ifdef _WIN32
+		const wchar_t* value = _wgetenv( name.c_str() );
+		return value ? wstring( value ) : wstring();
+	#else
+		const char* value = getenv( w2s( name ).c_str() );
+		return value ? s2w( value ) : wstring();
+	#endif
 }
 
 } // namespace Denom
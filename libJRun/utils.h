@@ -18,6 +18,10 @@
 #define UTILS_H_CBBDDBEE818FD0CE
 
 #include <stdint.h>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <filesystem>
 
 typedef const wchar_t* const ConstWChars;
 typedef const char* const ConstChars;
@@ -31,21 +35,50 @@ namespace Denom
 // ---------------------------------------------------------------------------------------------------------------------
 std::vector< std::wstring > convertCommandLine( int argc, char* argv[] );
 
+/// Arguments in UTF-8. On Linux 'argv' is copied as is, without conversion.
+std::vector< std::string > convertCommandLineUtf8( int argc, char* argv[] );
+
 // ---------------------------------------------------------------------------------------------------------------------
 /// Sleep thread for 'milliSec' milliseconds.
 void sleep( uint32_t milliSec );
 
 // ---------------------------------------------------------------------------------------------------------------------
-/// Generate pseudo random number
+/// Generate pseudo random number in [rangeMin, rangeMax]. Thread-safe, uses generator of current thread.
 uint32_t RangedRand( uint32_t rangeMin, uint32_t rangeMax );
 
 // ---------------------------------------------------------------------------------------------------------------------
-/// Convert string coded in UTF-8 to wstring (UTF-16)
-std::wstring s2w( const std::string& str );
+/// Convert string coded in UTF-8 to wstring (UTF-32 on Linux, UTF-16 on Windows).
+/// Invalid sequences are replaced with U+FFFD. See 'utf8ToWide'.
+std::wstring s2w( std::string_view str );
+
+/// The same, but result is written to 'out', its memory is reused.
+void s2w( std::string_view str, std::wstring& out );
 
 // ---------------------------------------------------------------------------------------------------------------------
 /// Convert wstring to string in UTF-8
-std::string w2s( const std::wstring& wstr );
+std::string w2s( std::wstring_view wstr );
+void w2s( std::wstring_view wstr, std::string& out );
+
+// ---------------------------------------------------------------------------------------------------------------------
+/// Convert file name to path and back without depending on current locale.
+std::filesystem::path toPath( const std::wstring& filename );
+std::wstring fromPath( const std::filesystem::path& path );
+
+// ---------------------------------------------------------------------------------------------------------------------
+/// File name in OS encoding - it is passed to OS without conversion: UTF-8 bytes on Linux, UTF-16 on Windows.
+/// Same type as std::filesystem::path::string_type, so 'path.native()' can be passed to file functions.
+/// File functions have overloads for std::wstring and for std::string_view in UTF-8, both are converted by:
+typedef std::filesystem::path::string_type NativeName;
+
+NativeName toNative( const std::wstring& filename );
+NativeName toNative( std::string_view utf8Filename );
+
+/// For messages.
+std::wstring fromNative( const NativeName& filename );
+
+// ---------------------------------------------------------------------------------------------------------------------
+/// Returns value of environment variable or empty string if it is not set.
+std::wstring getEnv( const std::wstring& name );
 
 
 // =====================================================================================================================
@@ -54,23 +87,37 @@ std::string w2s( const std::wstring& wstr );
 /// Class for speed measuring.
 /// Ticker t;
 /// DoSomeActions();
-/// cout << t.GetDiffMs();
+/// cout << t.diffMs();
+/// By default monotonic clock is used: clock_gettime( CLOCK_MONOTONIC ), QueryPerformanceCounter on Windows.
+/// In TSC mode CPU timestamp counter is read directly - it is several times cheaper, its frequency is calibrated
+/// once against monotonic clock. TSC mode is used only if CPU has invariant TSC, otherwise it is ignored.
 class Ticker
 {
 public:
 	/// Start ticker
-	Ticker();
+	explicit Ticker( bool useTsc = false );
 
 	/// Restart ticker
 	void restart();
 
 	/// Returns number of ticks since the ticker was started/restarted.
-	int64_t diff();
+	int64_t diff() const;
 
-	/// Returns number of milliseconds since the ticker was started/restarted.
-	int64_t diffMs();
+	/// Returns number of milli-, micro-, nanoseconds since the ticker was started/restarted.
+	int64_t diffMs() const;
+	int64_t diffUs() const;
+	int64_t diffNs() const;
+
+	/// Ticks per second.
+	int64_t getFrequency() const { return frequency; }
+
+	/// true, if TSC is used.
+	bool isTsc() const { return tsc; }
 
 private:
+	int64_t ticks() const;
+
+	bool tsc;
 	int64_t frequency;
 	int64_t startTicks;
 };